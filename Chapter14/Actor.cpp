@@ -8,8 +8,10 @@
 
 #include "Actor.h"
 #include "Game.h"
+#include <SDL/SDL.h>
 #include "Component.h"
 #include "LevelLoader.h"
+#include <algorithm>
 
 const char* Actor::TypeNames[NUM_ACTOR_TYPES] = {
 	"Actor",
@@ -19,20 +21,32 @@ const char* Actor::TypeNames[NUM_ACTOR_TYPES] = {
 	"TargetActor",
 };
 
+const int Actor::TypeAccess[NUM_ACTOR_TYPES] = {
+	Component::AReadOwner, // Actor
+	Component::AReadOwner | Component::AWriteOwner, // BallActor
+	Component::AReadOwner, // FollowActor
+	Component::AReadOwner, // PlaneActor
+	Component::AReadOwner, // TargetActor
+};
+
 Actor::Actor(Game* game)
 	:mState(EActive)
-	,mPosition(Vector3::Zero)
-	,mRotation(Quaternion::Identity)
-	,mScale(1.0f)
+	,mRecycled(false)
+	,mTransforms(game->GetTransforms())
 	,mGame(game)
-	,mRecomputeTransform(true)
 {
+	mTransformIndex = mTransforms->Add(this);
 	mGame->AddActor(this);
 }
 
 Actor::~Actor()
 {
-	mGame->RemoveActor(this);
+	// (Recycled actors already left the game and transform store)
+	if (!mRecycled)
+	{
+		mGame->RemoveActor(this);
+		mTransforms->Remove(mTransformIndex);
+	}
 	// Need to delete components
 	// Because ~Component calls RemoveComponent, need a different style loop
 	while (!mComponents.empty())
@@ -43,25 +57,13 @@ Actor::~Actor()
 
 void Actor::Update(float deltaTime)
 {
+	// (World transforms are computed in a batch before actors update)
 	if (mState == EActive)
 	{
-		if (mRecomputeTransform)
-		{
-			ComputeWorldTransform();
-		}
-		UpdateComponents(deltaTime);
 		UpdateActor(deltaTime);
 	}
 }
 
-void Actor::UpdateComponents(float deltaTime)
-{
-	for (auto comp : mComponents)
-	{
-		comp->Update(deltaTime);
-	}
-}
-
 void Actor::UpdateActor(float deltaTime)
 {
 }
@@ -85,14 +87,129 @@ void Actor::ActorInput(const uint8_t* keyState)
 
 }
 
+void Actor::Recycle()
+{
+	mRecycled = true;
+	mGame->RemoveActor(this);
+	mTransforms->Remove(mTransformIndex);
+	mTransformIndex = -1;
+	for (auto comp : mComponents)
+	{
+		comp->OnRecycle();
+	}
+	mGame->AddRecycledActor(this);
+}
+
+void Actor::Reuse()
+{
+	mRecycled = false;
+	mState = EActive;
+	mTransformIndex = mTransforms->Add(this);
+	mGame->AddActor(this);
+	for (auto comp : mComponents)
+	{
+		comp->OnReuse();
+	}
+	ResetActor();
+}
+
+void Actor::ResetActor()
+{
+}
+
+Actor* Actor::TakeRecycled(Game* game, TypeID type)
+{
+	return game->TakeRecycledActor(type);
+}
+
 void Actor::ComputeWorldTransform()
 {
-	mRecomputeTransform = false;
-	// Scale, then rotate, then translate
-	mWorldTransform = Matrix4::CreateScale(mScale);
-	mWorldTransform *= Matrix4::CreateFromQuaternion(mRotation);
-	mWorldTransform *= Matrix4::CreateTranslation(mPosition);
+	if (mTransforms->ComputeWorldTransform(mTransformIndex))
+	{
+		OnUpdateWorldTransform();
+	}
+}
+
+bool Actor::SetParent(Actor* parent)
+{
+	int parentIndex = parent ? parent->GetTransformIndex() : -1;
+	if (!mTransforms->SetParent(mTransformIndex, parentIndex))
+	{
+		SDL_Log("Can't attach an actor to itself or one of its children");
+		return false;
+	}
+	return true;
+}
+
+Actor* Actor::GetParent() const
+{
+	int parentIndex = mTransforms->GetParent(mTransformIndex);
+	return parentIndex >= 0 ? mTransforms->GetOwner(parentIndex) : nullptr;
+}
+
+Vector3 Actor::GetWorldPosition() const
+{
+	Vector3 pos;
+	Quaternion rot;
+	float scale;
+	mTransforms->GetWorldPose(mTransformIndex, pos, rot, scale);
+	return pos;
+}
+
+void Actor::SetWorldPosition(const Vector3& pos)
+{
+	int parentIndex = mTransforms->GetParent(mTransformIndex);
+	if (parentIndex < 0)
+	{
+		SetPosition(pos);
+		return;
+	}
+	// Undo the parent's world transform
+	Vector3 parentPos;
+	Quaternion parentRot;
+	float parentScale;
+	mTransforms->GetWorldPose(parentIndex, parentPos, parentRot, parentScale);
+	parentRot.Conjugate();
+	Vector3 local = Vector3::Transform(pos - parentPos, parentRot);
+	SetPosition(local * (1.0f / parentScale));
+}
+
+Quaternion Actor::GetWorldRotation() const
+{
+	Vector3 pos;
+	Quaternion rot;
+	float scale;
+	mTransforms->GetWorldPose(mTransformIndex, pos, rot, scale);
+	return rot;
+}
+
+void Actor::SetWorldRotation(const Quaternion& rotation)
+{
+	int parentIndex = mTransforms->GetParent(mTransformIndex);
+	if (parentIndex < 0)
+	{
+		SetRotation(rotation);
+		return;
+	}
+	Vector3 parentPos;
+	Quaternion parentRot;
+	float parentScale;
+	mTransforms->GetWorldPose(parentIndex, parentPos, parentRot, parentScale);
+	parentRot.Conjugate();
+	SetRotation(Quaternion::Concatenate(rotation, parentRot));
+}
+
+float Actor::GetWorldScale() const
+{
+	Vector3 pos;
+	Quaternion rot;
+	float scale;
+	mTransforms->GetWorldPose(mTransformIndex, pos, rot, scale);
+	return scale;
+}
 
+void Actor::OnUpdateWorldTransform()
+{
 	// Inform components world transform updated
 	for (auto comp : mComponents)
 	{
@@ -174,9 +291,15 @@ void Actor::LoadProperties(const rapidjson::Value& inObj)
 	}
 
 	// Load position, rotation, and scale, and compute transform
-	JsonHelper::GetVector3(inObj, "position", mPosition);
-	JsonHelper::GetQuaternion(inObj, "rotation", mRotation);
-	JsonHelper::GetFloat(inObj, "scale", mScale);
+	Vector3 pos = GetPosition();
+	Quaternion rot = GetRotation();
+	float scale = GetScale();
+	JsonHelper::GetVector3(inObj, "position", pos);
+	JsonHelper::GetQuaternion(inObj, "rotation", rot);
+	JsonHelper::GetFloat(inObj, "scale", scale);
+	SetPosition(pos);
+	SetRotation(rot);
+	SetScale(scale);
 	ComputeWorldTransform();
 }
 
@@ -193,7 +316,7 @@ void Actor::SaveProperties(rapidjson::Document::AllocatorType& alloc, rapidjson:
 	}
 
 	JsonHelper::AddString(alloc, inObj, "state", state);
-	JsonHelper::AddVector3(alloc, inObj, "position", mPosition);
-	JsonHelper::AddQuaternion(alloc, inObj, "rotation", mRotation);
-	JsonHelper::AddFloat(alloc, inObj, "scale", mScale);
+	JsonHelper::AddVector3(alloc, inObj, "position", GetPosition());
+	JsonHelper::AddQuaternion(alloc, inObj, "rotation", GetRotation());
+	JsonHelper::AddFloat(alloc, inObj, "scale", GetScale());
 }
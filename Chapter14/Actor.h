@@ -11,6 +11,9 @@
 #include "Math.h"
 #include <rapidjson/document.h>
 #include "Component.h"
+#include "TransformStore.h"
+#include "PoolAllocator.h"
+#include "ActorHandle.h"
 
 class Actor
 {
@@ -27,6 +30,9 @@ public:
 	};
 
 	static const char* TypeNames[NUM_ACTOR_TYPES];
+	// What UpdateActor touches for each type (see Component::Access)
+	// Types that don't write to the world update in parallel
+	static const int TypeAccess[NUM_ACTOR_TYPES];
 
 	enum State
 	{
@@ -39,29 +45,56 @@ public:
 	virtual ~Actor();
 
 	// Update function called from Game (not overridable)
+	// (Components are updated separately, by the ComponentRegistry)
 	void Update(float deltaTime);
-	// Updates all the components attached to the actor (not overridable)
-	void UpdateComponents(float deltaTime);
 	// Any actor-specific update code (overridable)
+	// Actors don't update in the order they were added: types that
+	// don't write to the world go first (in parallel), then the rest,
+	// so UpdateActor can't rely on another actor having updated yet
 	virtual void UpdateActor(float deltaTime);
 	// ProcessInput function called from Game (not overridable)
 	void ProcessInput(const uint8_t* keyState);
 	// Any actor-specific input code (overridable)
 	virtual void ActorInput(const uint8_t* keyState);
 
-	// Getters/setters
-	const Vector3& GetPosition() const { return mPosition; }
-	void SetPosition(const Vector3& pos) { mPosition = pos; mRecomputeTransform = true; }
-	float GetScale() const { return mScale; }
-	void SetScale(float scale) { mScale = scale; mRecomputeTransform = true; }
-	const Quaternion& GetRotation() const { return mRotation; }
-	void SetRotation(const Quaternion& rotation) { mRotation = rotation;   mRecomputeTransform = true; }
+	// Getters/setters (the transform itself lives in the game's TransformStore)
+	Vector3 GetPosition() const { return mTransforms->GetPosition(mTransformIndex); }
+	void SetPosition(const Vector3& pos) { mTransforms->SetPosition(mTransformIndex, pos); }
+	float GetScale() const { return mTransforms->GetScale(mTransformIndex); }
+	void SetScale(float scale) { mTransforms->SetScale(mTransformIndex, scale); }
+	Quaternion GetRotation() const { return mTransforms->GetRotation(mTransformIndex); }
+	void SetRotation(const Quaternion& rotation) { mTransforms->SetRotation(mTransformIndex, rotation); }
 	
+	// Compute the world transform right away (rather than waiting
+	// for the next batched update of all dirty transforms), and call
+	// OnUpdateWorldTransform if it changed
 	void ComputeWorldTransform();
-	const Matrix4& GetWorldTransform() const { return mWorldTransform; }
-
-	Vector3 GetForward() const { return Vector3::Transform(Vector3::UnitX, mRotation); }
-	Vector3 GetRight() const { return Vector3::Transform(Vector3::UnitY, mRotation); }
+	const Matrix4& GetWorldTransform() const { return mTransforms->GetWorldTransform(mTransformIndex); }
+	// Transform to draw with, interpolated between simulation ticks
+	const Matrix4& GetRenderTransform() const { return mTransforms->GetRenderTransform(mTransformIndex); }
+	// Called once the world transform is recomputed
+	void OnUpdateWorldTransform();
+
+	// Attach to a parent actor (or detach, if parent is null)
+	// Position, rotation and scale are then relative to the parent
+	bool SetParent(Actor* parent);
+	Actor* GetParent() const;
+
+	// Position, rotation and scale relative to the world
+	// (the same as above if the actor has no parent)
+	Vector3 GetWorldPosition() const;
+	void SetWorldPosition(const Vector3& pos);
+	Quaternion GetWorldRotation() const;
+	void SetWorldRotation(const Quaternion& rotation);
+	float GetWorldScale() const;
+
+	int GetTransformIndex() const { return mTransformIndex; }
+	void SetTransformIndex(int index) { mTransformIndex = index; }
+
+	Vector3 GetForward() const { return Vector3::Transform(Vector3::UnitX, GetRotation()); }
+	Vector3 GetRight() const { return Vector3::Transform(Vector3::UnitY, GetRotation()); }
+	Vector3 GetWorldForward() const { return Vector3::Transform(Vector3::UnitX, GetWorldRotation()); }
+	Vector3 GetWorldRight() const { return Vector3::Transform(Vector3::UnitY, GetWorldRotation()); }
 
 	void RotateToNewForward(const Vector3& forward);
 
@@ -70,6 +103,10 @@ public:
 
 	class Game* GetGame() { return mGame; }
 
+	// Handle for weak references to this actor (set by Game)
+	const ActorHandle& GetHandle() const { return mHandle; }
+	void SetHandle(const ActorHandle& handle) { mHandle = handle; }
+
 
 	// Add/remove components
 	void AddComponent(class Component* component);
@@ -84,13 +121,43 @@ public:
 	template <typename T>
 	static Actor* Create(class Game* game, const rapidjson::Value& inObj)
 	{
-		// Dynamically allocate actor of type T
-		T* t = new T(game);
+		// Get an actor of type T (new or recycled)
+		T* t = Spawn<T>(game);
 		// Call LoadProperties on new actor
 		t->LoadProperties(inObj);
 		return t;
 	}
 
+	// Get an actor of type T, reusing a recycled one if there is one
+	template <typename T>
+	static T* Spawn(class Game* game)
+	{
+		T* t = static_cast<T*>(TakeRecycled(game, T::StaticType));
+		if (t)
+		{
+			t->Reuse();
+		}
+		else
+		{
+			t = new T(game);
+		}
+		return t;
+	}
+
+	// Types that opt in to recycling aren't deleted when they die,
+	// but kept (along with their components) to be spawned again
+	virtual bool IsRecyclable() const { return false; }
+	// Remove from the game and any systems, so it can be reused later
+	void Recycle();
+	// Add back to the game and systems, then reset the actor
+	void Reuse();
+	// Reset any actor-specific state before reuse (overridable)
+	virtual void ResetActor();
+
+	// Actors are allocated from size-class pools
+	static void* operator new(size_t size) { return PoolAllocator::Allocate(size); }
+	static void operator delete(void* ptr, size_t size) { PoolAllocator::Free(ptr, size); }
+
 	// Search through component vector for one of type
 	Component* GetComponentOfType(Component::TypeID type)
 	{
@@ -106,19 +173,23 @@ public:
 		return comp;
 	}
 
-	virtual TypeID GetType() const { return TActor; }
+	static const TypeID StaticType = TActor;
+	virtual TypeID GetType() const { return StaticType; }
 
 	const std::vector<Component*>& GetComponents() const { return mComponents; }
 private:
+	// Get a recycled actor of this type from the game (or null)
+	static Actor* TakeRecycled(class Game* game, TypeID type);
+
 	// Actor's state
 	State mState;
+	// Whether the actor is currently recycled (and not in the game)
+	bool mRecycled;
+	ActorHandle mHandle;
 
 	// Transform
-	Matrix4 mWorldTransform;
-	Vector3 mPosition;
-	Quaternion mRotation;
-	float mScale;
-	bool mRecomputeTransform;
+	class TransformStore* mTransforms;
+	int mTransformIndex;
 
 	std::vector<Component*> mComponents;
 	class Game* mGame;
@@ -0,0 +1,45 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+
+// Weak reference to an actor. Look it up with Game::GetActor, which
+// returns null once the actor is gone (even if its slot is reused,
+// since the generation won't match)
+struct ActorHandle
+{
+	ActorHandle()
+		:mIndex(0)
+		,mGeneration(0)
+	{
+	}
+
+	ActorHandle(uint32_t index, uint32_t generation)
+		:mIndex(index)
+		,mGeneration(generation)
+	{
+	}
+
+	// Generation 0 is never used by a live actor
+	bool IsNull() const { return mGeneration == 0; }
+
+	bool operator==(const ActorHandle& other) const
+	{
+		return mIndex == other.mIndex && mGeneration == other.mGeneration;
+	}
+	bool operator!=(const ActorHandle& other) const
+	{
+		return !(*this == other);
+	}
+
+	// Slot in the game's actor table
+	uint32_t mIndex;
+	// Incremented every time the slot is freed
+	uint32_t mGeneration;
+};
@@ -7,6 +7,7 @@
 // ----------------------------------------------------------------
 
 #include "Animation.h"
+#include "Profiler.h"
 #include "Skeleton.h"
 #include <rapidjson/document.h>
 #include <SDL/SDL_log.h>
@@ -117,6 +118,7 @@ bool Animation::Load(const std::string& fileName)
 
 void Animation::GetGlobalPoseAtTime(std::vector<Matrix4>& outPoses, const Skeleton* inSkeleton, float inTime) const
 {
+	PROFILE_SCOPE("Animation::GetGlobalPoseAtTime");
 	if (outPoses.size() != mNumBones)
 	{
 		outPoses.resize(mNumBones);
@@ -0,0 +1,131 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "AssetLoader.h"
+#include "Renderer.h"
+#include <GL/glew.h>
+#include <SDL/SDL.h>
+
+AssetLoader::AssetLoader(Renderer* renderer, JobSystem* jobs)
+	:mUploadBuffer(0)
+	,mRenderer(renderer)
+	,mJobs(jobs)
+{
+	glGenBuffers(1, &mUploadBuffer);
+	mCompressTextures = GLEW_EXT_texture_compression_s3tc != 0;
+}
+
+AssetLoader::~AssetLoader()
+{
+	FinishAll();
+	glDeleteBuffers(1, &mUploadBuffer);
+}
+
+void AssetLoader::LoadTexture(Texture* texture, const std::string& fileName)
+{
+	Request* request = new Request();
+	request->mTexture = texture;
+	request->mMesh = nullptr;
+	request->mFileName = fileName;
+	request->mSuccess = false;
+	bool compress = mCompressTextures;
+	mJobs->Run([request, compress]() {
+		request->mSuccess = Texture::LoadImageData(request->mFileName,
+			compress, request->mImage);
+	}, &request->mCounter);
+	mPending.emplace_back(request);
+}
+
+void AssetLoader::LoadMesh(Mesh* mesh, const std::string& fileName)
+{
+	Request* request = new Request();
+	request->mTexture = nullptr;
+	request->mMesh = mesh;
+	request->mFileName = fileName;
+	request->mSuccess = false;
+	mJobs->Run([request]() {
+		request->mSuccess = Mesh::LoadData(request->mFileName,
+			request->mMeshData);
+	}, &request->mCounter);
+	mPending.emplace_back(request);
+}
+
+void AssetLoader::Update(float budgetMS)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 budget = static_cast<Uint64>(budgetMS *
+		SDL_GetPerformanceFrequency() / 1000.0f);
+	// Without any workers, jobs only run when someone waits on them,
+	// so decode one here each frame
+	if (mJobs->GetNumThreads() == 1)
+	{
+		mJobs->RunOneJob();
+	}
+	while (!mPending.empty() && mPending.front()->mCounter.IsDone())
+	{
+		Request* request = mPending.front();
+		mPending.pop_front();
+		Complete(request);
+		// (Always finish at least one, so big assets still get through)
+		if (SDL_GetPerformanceCounter() - start > budget)
+		{
+			break;
+		}
+	}
+}
+
+void AssetLoader::Finish(const void* asset)
+{
+	// Earlier requests finish first, to keep them in order
+	for (size_t i = 0; i < mPending.size(); i++)
+	{
+		if (mPending[i]->mTexture == asset || mPending[i]->mMesh == asset)
+		{
+			for (size_t j = 0; j <= i; j++)
+			{
+				Request* request = mPending.front();
+				mPending.pop_front();
+				mJobs->Wait(request->mCounter);
+				Complete(request);
+			}
+			break;
+		}
+	}
+}
+
+void AssetLoader::FinishAll()
+{
+	while (!mPending.empty())
+	{
+		Request* request = mPending.front();
+		mPending.pop_front();
+		mJobs->Wait(request->mCounter);
+		Complete(request);
+	}
+}
+
+void AssetLoader::Complete(Request* request)
+{
+	if (!request->mSuccess)
+	{
+		// Failed assets keep their placeholder (or stay empty)
+		SDL_Log("Failed to stream %s", request->mFileName.c_str());
+	}
+	else if (request->mTexture)
+	{
+		request->mTexture->Create(request->mFileName, request->mImage,
+			mUploadBuffer);
+	}
+	else
+	{
+		// The mesh's textures stream in after it
+		request->mMesh->Create(request->mFileName, request->mMeshData,
+			mRenderer, true);
+	}
+	delete request;
+}
@@ -0,0 +1,62 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <string>
+#include <deque>
+#include "JobSystem.h"
+#include "Texture.h"
+#include "Mesh.h"
+
+// Streams textures and meshes in the background. Files are read and
+// decoded by jobs, and the GL objects are created on the main thread
+// in Update, a few at a time, so loading doesn't hitch the frame.
+// Assets are finished in the order they were requested
+class AssetLoader
+{
+public:
+	AssetLoader(class Renderer* renderer, class JobSystem* jobs);
+	~AssetLoader();
+
+	// Queue an asset that's already been given a placeholder
+	void LoadTexture(Texture* texture, const std::string& fileName);
+	void LoadMesh(Mesh* mesh, const std::string& fileName);
+
+	// Create GL objects for decoded assets, until this much
+	// time (in milliseconds) has been spent
+	void Update(float budgetMS);
+	// Wait for this asset to finish loading, if it's queued
+	void Finish(const void* asset);
+	// Wait for everything queued to finish
+	void FinishAll();
+
+	size_t GetNumPending() const { return mPending.size(); }
+private:
+	struct Request
+	{
+		Texture* mTexture;
+		Mesh* mMesh;
+		std::string mFileName;
+		// Written by the decode job
+		Texture::ImageData mImage;
+		Mesh::Data mMeshData;
+		bool mSuccess;
+		JobCounter mCounter;
+	};
+
+	// Create the GL objects for a decoded request, and delete it
+	void Complete(Request* request);
+
+	std::deque<Request*> mPending;
+	// Pixel buffer textures are uploaded through
+	unsigned int mUploadBuffer;
+	class Renderer* mRenderer;
+	class JobSystem* mJobs;
+	// Whether cooked (block compressed) textures are used
+	bool mCompressTextures;
+};
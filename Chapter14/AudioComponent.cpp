@@ -67,6 +67,12 @@ void AudioComponent::OnUpdateWorldTransform()
 	}
 }
 
+void AudioComponent::OnRecycle()
+{
+	Component::OnRecycle();
+	StopAllEvents();
+}
+
 SoundEvent AudioComponent::PlayEvent(const std::string& name)
 {
 	SoundEvent e = mOwner->GetGame()->GetAudioSystem()->PlayEvent(name);
@@ -20,6 +20,7 @@ public:
 
 	void Update(float deltaTime) override;
 	void OnUpdateWorldTransform() override;
+	void OnRecycle() override;
 
 	SoundEvent PlayEvent(const std::string& name);
 	void StopAllEvents();
@@ -7,6 +7,8 @@
 // ----------------------------------------------------------------
 
 #include "AudioSystem.h"
+#include "Profiler.h"
+#include "Game.h"
 #include <SDL/SDL_log.h>
 #include <fmod_studio.hpp>
 #include <fmod_errors.h>
@@ -27,6 +29,13 @@ AudioSystem::~AudioSystem()
 
 bool AudioSystem::Initialize()
 {
+	// Headless mode has no FMOD system, so every event
+	// just gets an invalid ID and nothing plays
+	if (mGame->IsHeadless())
+	{
+		return true;
+	}
+
 	// Initialize debug logging
 	FMOD::Debug_Initialize(
 		FMOD_DEBUG_LEVEL_ERROR, // Log only errors
@@ -78,8 +87,8 @@ void AudioSystem::Shutdown()
 
 void AudioSystem::LoadBank(const std::string& name)
 {
-	// Prevent double-loading
-	if (mBanks.find(name) != mBanks.end())
+	// Prevent double-loading (or loading without FMOD)
+	if (!mSystem || mBanks.find(name) != mBanks.end())
 	{
 		return;
 	}
@@ -238,6 +247,7 @@ SoundEvent AudioSystem::PlayEvent(const std::string& name)
 
 void AudioSystem::Update(float deltaTime)
 {
+	PROFILE_SCOPE("AudioSystem::Update");
 	// Find any stopped event instances
 	std::vector<unsigned int> done;
 	for (auto& iter : mEventInstances)
@@ -261,7 +271,10 @@ void AudioSystem::Update(float deltaTime)
 	}
 
 	// Update FMOD
-	mSystem->update();
+	if (mSystem)
+	{
+		mSystem->update();
+	}
 }
 
 namespace
@@ -280,6 +293,11 @@ namespace
 
 void AudioSystem::SetListener(const Matrix4& viewMatrix)
 {
+	if (!mSystem)
+	{
+		return;
+	}
+
 	// Invert the view matrix to get the correct vectors
 	Matrix4 invView = viewMatrix;
 	invView.Invert();
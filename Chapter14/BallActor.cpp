@@ -21,7 +21,7 @@ BallActor::BallActor(Game* game)
 {
 	//SetScale(10.0f);
 	MeshComponent* mc = new MeshComponent(this);
-	Mesh* mesh = GetGame()->GetRenderer()->GetMesh("Assets/Sphere.gpmesh");
+	Mesh* mesh = GetGame()->GetRenderer()->GetMesh("Assets/Sphere.gpmesh", true);
 	mc->SetMesh(mesh);
 	BallMove* move = new BallMove(this);
 	move->SetForwardSpeed(1500.0f);
@@ -39,6 +39,12 @@ void BallActor::UpdateActor(float deltaTime)
 	}
 }
 
+void BallActor::ResetActor()
+{
+	Actor::ResetActor();
+	mLifeSpan = 2.0f;
+}
+
 void BallActor::HitTarget()
 {
 	mAudioComp->PlayEvent("event:/Ding");
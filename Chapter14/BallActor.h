@@ -16,13 +16,18 @@ public:
 
 	void UpdateActor(float deltaTime) override;
 
+	// Balls are short-lived, so recycle them rather than delete
+	bool IsRecyclable() const override { return true; }
+	void ResetActor() override;
+
 	void HitTarget();
 
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
 
-	TypeID GetType() const override { return TBallActor; }
+	static const TypeID StaticType = TBallActor;
+	TypeID GetType() const override { return StaticType; }
 private:
 	class AudioComponent* mAudioComp;
 	float mLifeSpan;
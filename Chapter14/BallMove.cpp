@@ -12,6 +12,7 @@
 #include "PhysWorld.h"
 #include "TargetActor.h"
 #include "BallActor.h"
+#include "CommandBuffer.h"
 
 BallMove::BallMove(Actor* owner)
 	:MoveComponent(owner)
@@ -24,8 +25,8 @@ void BallMove::Update(float deltaTime)
 	PhysWorld* phys = mOwner->GetGame()->GetPhysWorld();
 
 	// Construct segment in direction of travel
-	Vector3 start = mOwner->GetPosition();
-	Vector3 dir = mOwner->GetForward();
+	Vector3 start = mOwner->GetWorldPosition();
+	Vector3 dir = mOwner->GetWorldForward();
 	Vector3 end = start + dir * segmentLength;
 	// Create line segment
 	LineSegment l(start, end);
@@ -40,7 +41,17 @@ void BallMove::Update(float deltaTime)
 		TargetActor* target = dynamic_cast<TargetActor*>(info.mActor);
 		if (target)
 		{
-			static_cast<BallActor*>(mOwner)->HitTarget();
+			// Playing a sound isn't safe during the parallel update,
+			// so do it once everything has finished updating
+			Game* game = mOwner->GetGame();
+			ActorHandle handle = mOwner->GetHandle();
+			game->GetCommands()->Push([game, handle]() {
+				Actor* ball = game->GetActor(handle);
+				if (ball)
+				{
+					static_cast<BallActor*>(ball)->HitTarget();
+				}
+			});
 		}
 	}
 	MoveComponent::Update(deltaTime);
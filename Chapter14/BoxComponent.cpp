@@ -26,21 +26,33 @@ BoxComponent::~BoxComponent()
 	mOwner->GetGame()->GetPhysWorld()->RemoveBox(this);
 }
 
+void BoxComponent::OnRecycle()
+{
+	Component::OnRecycle();
+	mOwner->GetGame()->GetPhysWorld()->RemoveBox(this);
+}
+
+void BoxComponent::OnReuse()
+{
+	Component::OnReuse();
+	mOwner->GetGame()->GetPhysWorld()->AddBox(this);
+}
+
 void BoxComponent::OnUpdateWorldTransform()
 {
 	// Reset to object space box
 	mWorldBox = mObjectBox;
 	// Scale
-	mWorldBox.mMin *= mOwner->GetScale();
-	mWorldBox.mMax *= mOwner->GetScale();
+	mWorldBox.mMin *= mOwner->GetWorldScale();
+	mWorldBox.mMax *= mOwner->GetWorldScale();
 	// Rotate (if we want to)
 	if (mShouldRotate)
 	{
-		mWorldBox.Rotate(mOwner->GetRotation());
+		mWorldBox.Rotate(mOwner->GetWorldRotation());
 	}
 	// Translate
-	mWorldBox.mMin += mOwner->GetPosition();
-	mWorldBox.mMax += mOwner->GetPosition();
+	mWorldBox.mMin += mOwner->GetWorldPosition();
+	mWorldBox.mMax += mOwner->GetWorldPosition();
 }
 
 void BoxComponent::LoadProperties(const rapidjson::Value& inObj)
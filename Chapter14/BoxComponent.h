@@ -16,6 +16,8 @@ public:
 	BoxComponent(class Actor* owner, int updateOrder = 100);
 	~BoxComponent();
 
+	void OnRecycle() override;
+	void OnReuse() override;
 	void OnUpdateWorldTransform() override;
 
 	void SetObjectBox(const AABB& model) { mObjectBox = model; }
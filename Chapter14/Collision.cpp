@@ -18,6 +18,11 @@
 #include <algorithm>
 #include <array>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define COLLISION_SSE 1
+#include <xmmintrin.h>
+#endif
+
 LineSegment::LineSegment(const Vector3& start, const Vector3& end)
 	:mStart(start)
 	,mEnd(end)
@@ -314,6 +319,104 @@ bool Intersect(const Sphere& s, const AABB& box)
 	return distSq <= (s.mRadius * s.mRadius);
 }
 
+Frustum::Frustum(const Matrix4& viewProj)
+{
+	// With row vectors, clip space = p * viewProj, so each clip
+	// coordinate is a column of the matrix
+	const float (&m)[4][4] = viewProj.mat;
+	float cols[4][4];
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			cols[c][r] = m[r][c];
+		}
+	}
+
+	// (-w <= x <= w, -w <= y <= w, -w <= z <= w)
+	const float signs[6] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+	const int axes[6] = { 0, 0, 1, 1, 2, 2 };
+	for (int i = 0; i < 6; i++)
+	{
+		const float* axis = cols[axes[i]];
+		Vector3 normal(cols[3][0] + signs[i] * axis[0],
+			cols[3][1] + signs[i] * axis[1],
+			cols[3][2] + signs[i] * axis[2]);
+		float d = cols[3][3] + signs[i] * axis[3];
+		// Normalize, so distances are in world units
+		float invLength = 1.0f / normal.Length();
+		// (SignedDist is dot(p, n) - mD, so negate d)
+		mPlanes.emplace_back(normal * invLength, -d * invLength);
+	}
+}
+
+void Frustum::TestSpheres(const float* centerX, const float* centerY,
+	const float* centerZ, const float* radius, size_t count,
+	uint8_t* outVisible) const
+{
+	size_t i = 0;
+#ifdef COLLISION_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(centerX + i);
+		__m128 y = _mm_loadu_ps(centerY + i);
+		__m128 z = _mm_loadu_ps(centerZ + i);
+		__m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+		// Inside as long as no plane has the whole sphere behind it
+		__m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+		for (const Plane& p : mPlanes)
+		{
+			__m128 dist = _mm_mul_ps(x, _mm_set1_ps(p.mNormal.x));
+			dist = _mm_add_ps(dist, _mm_mul_ps(y, _mm_set1_ps(p.mNormal.y)));
+			dist = _mm_add_ps(dist, _mm_mul_ps(z, _mm_set1_ps(p.mNormal.z)));
+			dist = _mm_sub_ps(dist, _mm_set1_ps(p.mD));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negR));
+		}
+		int mask = _mm_movemask_ps(inside);
+		outVisible[i] = mask & 1;
+		outVisible[i + 1] = (mask >> 1) & 1;
+		outVisible[i + 2] = (mask >> 2) & 1;
+		outVisible[i + 3] = (mask >> 3) & 1;
+	}
+#endif
+	// Whatever is left over
+	for (; i < count; i++)
+	{
+		Sphere s(Vector3(centerX[i], centerY[i], centerZ[i]), radius[i]);
+		outVisible[i] = Intersect(*this, s) ? 1 : 0;
+	}
+}
+
+bool Intersect(const Frustum& f, const Sphere& s)
+{
+	for (const Plane& p : f.mPlanes)
+	{
+		if (p.SignedDist(s.mCenter) < -s.mRadius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Intersect(const Frustum& f, const AABB& box)
+{
+	Vector3 center = (box.mMin + box.mMax) * 0.5f;
+	Vector3 extents = (box.mMax - box.mMin) * 0.5f;
+	for (const Plane& p : f.mPlanes)
+	{
+		// Projected "radius" of the box onto the plane normal
+		float r = extents.x * Math::Abs(p.mNormal.x) +
+			extents.y * Math::Abs(p.mNormal.y) +
+			extents.z * Math::Abs(p.mNormal.z);
+		if (p.SignedDist(center) < -r)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 bool Intersect(const LineSegment& l, const Sphere& s, float& outT)
 {
 	// Compute X, Y, a, b, c as per equations
@@ -9,6 +9,7 @@
 #pragma once
 #include "Math.h"
 #include <vector>
+#include <cstdint>
 
 struct LineSegment
 {
@@ -78,6 +79,21 @@ struct Capsule
 	float mRadius;
 };
 
+struct Frustum
+{
+	// Extract the six planes from a view-projection matrix
+	// (normals point inward, so positive distance is inside)
+	Frustum(const Matrix4& viewProj);
+	// Test four spheres at a time, given as arrays of their center
+	// x/y/z and radius. Sets outVisible[i] to 1 if sphere i is at
+	// least partly inside, or 0 if it's entirely outside
+	void TestSpheres(const float* centerX, const float* centerY,
+		const float* centerZ, const float* radius, size_t count,
+		uint8_t* outVisible) const;
+
+	std::vector<Plane> mPlanes;
+};
+
 struct ConvexPolygon
 {
 	bool Contains(const Vector2& point) const;
@@ -90,6 +106,9 @@ bool Intersect(const Sphere& a, const Sphere& b);
 bool Intersect(const AABB& a, const AABB& b);
 bool Intersect(const Capsule& a, const Capsule& b);
 bool Intersect(const Sphere& s, const AABB& box);
+// These are conservative (true if the shape is at least partly inside)
+bool Intersect(const Frustum& f, const Sphere& s);
+bool Intersect(const Frustum& f, const AABB& box);
 
 bool Intersect(const LineSegment& l, const Sphere& s, float& outT);
 bool Intersect(const LineSegment& l, const Plane& p, float& outT);
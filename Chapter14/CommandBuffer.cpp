@@ -0,0 +1,59 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "CommandBuffer.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+
+CommandBuffer::CommandBuffer(int numThreads)
+{
+	// (Separate allocations, so threads aren't writing to
+	// neighboring memory)
+	for (int i = 0; i < numThreads; i++)
+	{
+		mCommands.emplace_back(new std::vector<Command>());
+	}
+}
+
+CommandBuffer::~CommandBuffer()
+{
+	for (auto list : mCommands)
+	{
+		delete list;
+	}
+}
+
+void CommandBuffer::Push(const Command& command)
+{
+	mCommands[JobSystem::GetThreadIndex()]->emplace_back(command);
+}
+
+void CommandBuffer::Apply()
+{
+	PROFILE_SCOPE("CommandBuffer::Apply");
+	bool applied = true;
+	while (applied)
+	{
+		applied = false;
+		for (auto list : mCommands)
+		{
+			if (list->empty())
+			{
+				continue;
+			}
+			// Swap out the list first, since a command might record more
+			mApplying.swap(*list);
+			for (auto& command : mApplying)
+			{
+				command();
+			}
+			mApplying.clear();
+			applied = true;
+		}
+	}
+}
@@ -0,0 +1,35 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <functional>
+
+// Commands recorded during parallel updates (spawning actors, playing
+// sounds, anything that touches more than the updating actor), to be
+// applied later on the main thread. Each thread records into its own
+// list, so recording doesn't need a lock
+class CommandBuffer
+{
+public:
+	typedef std::function<void()> Command;
+
+	CommandBuffer(int numThreads);
+	~CommandBuffer();
+
+	// Record a command from the calling thread
+	void Push(const Command& command);
+	// Run all recorded commands, in thread order
+	// (must be called on the main thread, with no updates running)
+	void Apply();
+private:
+	// One list per JobSystem thread index
+	std::vector<std::vector<Command>*> mCommands;
+	// Scratch list, so commands can record more commands while applying
+	std::vector<Command> mApplying;
+};
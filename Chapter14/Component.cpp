@@ -9,6 +9,8 @@
 #include "Component.h"
 #include "Actor.h"
 #include "LevelLoader.h"
+#include "Game.h"
+#include "ComponentRegistry.h"
 
 const char* Component::TypeNames[NUM_COMPONENT_TYPES] = {
 	"Component",
@@ -26,16 +28,70 @@ const char* Component::TypeNames[NUM_COMPONENT_TYPES] = {
 	"TargetComponent"
 };
 
+const bool Component::TypeUpdates[NUM_COMPONENT_TYPES] = {
+	false, // Component
+	true, // AudioComponent
+	true, // BallMove
+	false, // BoxComponent
+	false, // CameraComponent
+	true, // FollowCamera
+	false, // MeshComponent
+	true, // MoveComponent
+	true, // SkeletalMeshComponent
+	false, // SpriteComponent
+	true, // MirrorCamera
+	false, // PointLightComponent
+	false // TargetComponent
+};
+
+const Component::UpdateStage Component::TypeStages[NUM_COMPONENT_TYPES] = {
+	EGameplayStage, // Component
+	EGameplayStage, // AudioComponent
+	EGameplayStage, // BallMove
+	EGameplayStage, // BoxComponent
+	EGameplayStage, // CameraComponent
+	EGameplayStage, // FollowCamera
+	EGameplayStage, // MeshComponent
+	EGameplayStage, // MoveComponent
+	EAnimationStage, // SkeletalMeshComponent
+	EGameplayStage, // SpriteComponent
+	EGameplayStage, // MirrorCamera
+	EGameplayStage, // PointLightComponent
+	EGameplayStage // TargetComponent
+};
+
+const int Component::TypeAccess[NUM_COMPONENT_TYPES] = {
+	AReadOwner, // Component
+	AWriteOwner | AReadWorld, // AudioComponent
+	AReadOwner | AWriteOwner | AReadWorld, // BallMove
+	AReadOwner, // BoxComponent
+	AReadOwner | AWriteWorld, // CameraComponent
+	AReadOwner | AWriteWorld, // FollowCamera
+	AReadOwner, // MeshComponent
+	AReadOwner | AWriteOwner | AReadWorld, // MoveComponent
+	AReadOwner | AWriteOwner, // SkeletalMeshComponent
+	AReadOwner, // SpriteComponent
+	AReadOwner | AWriteWorld, // MirrorCamera
+	AReadOwner, // PointLightComponent
+	AReadOwner // TargetComponent
+};
+
 Component::Component(Actor* owner, int updateOrder)
 	:mOwner(owner)
 	,mUpdateOrder(updateOrder)
+	,mRegistryBucket(-1)
+	,mRegistryIndex(-1)
+	,mSystemIndex(-1)
 {
 	// Add to actor's vector of components
 	mOwner->AddComponent(this);
+	// Add to the game's update lists
+	mOwner->GetGame()->GetComponentRegistry()->Register(this);
 }
 
 Component::~Component()
 {
+	mOwner->GetGame()->GetComponentRegistry()->Unregister(this);
 	mOwner->RemoveComponent(this);
 }
 
@@ -47,9 +103,28 @@ void Component::OnUpdateWorldTransform()
 {
 }
 
+void Component::OnRecycle()
+{
+	mOwner->GetGame()->GetComponentRegistry()->Unregister(this);
+}
+
+void Component::OnReuse()
+{
+	mOwner->GetGame()->GetComponentRegistry()->Register(this);
+}
+
 void Component::LoadProperties(const rapidjson::Value& inObj)
 {
-	JsonHelper::GetInt(inObj, "updateOrder", mUpdateOrder);
+	int updateOrder = mUpdateOrder;
+	if (JsonHelper::GetInt(inObj, "updateOrder", updateOrder) &&
+		updateOrder != mUpdateOrder)
+	{
+		// Changing update order means a different update list
+		ComponentRegistry* registry = mOwner->GetGame()->GetComponentRegistry();
+		registry->Unregister(this);
+		mUpdateOrder = updateOrder;
+		registry->Register(this);
+	}
 }
 
 void Component::SaveProperties(rapidjson::Document::AllocatorType& alloc, rapidjson::Value& inObj) const
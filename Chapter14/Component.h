@@ -9,6 +9,7 @@
 #pragma once
 #include "Math.h"
 #include <rapidjson/document.h>
+#include "PoolAllocator.h"
 
 class Component
 {
@@ -33,6 +34,35 @@ public:
 	};
 
 	static const char* TypeNames[NUM_COMPONENT_TYPES];
+	// Whether components of each type do anything in Update
+	// (the ones that don't are never added to the update lists)
+	static const bool TypeUpdates[NUM_COMPONENT_TYPES];
+
+	// Which part of the frame each type updates in
+	enum UpdateStage
+	{
+		// Runs on the main thread (may touch other actors or systems)
+		EGameplayStage = 0,
+		// Only touches its own component, so runs on worker threads
+		EAnimationStage,
+
+		NUM_UPDATE_STAGES
+	};
+	static const UpdateStage TypeStages[NUM_COMPONENT_TYPES];
+
+	// What an update is allowed to touch. The owner includes the
+	// owning actor and its other components. The world is anything
+	// else (other actors, the renderer, audio, physics)
+	enum Access
+	{
+		AReadOwner = 1 << 0,
+		AWriteOwner = 1 << 1,
+		AReadWorld = 1 << 2,
+		AWriteWorld = 1 << 3
+	};
+	// Types that don't write to the world update in parallel (and
+	// must record anything else through Game::GetCommands)
+	static const int TypeAccess[NUM_COMPONENT_TYPES];
 
 	// Constructor
 	// (the lower the update order, the earlier the component updates)
@@ -45,12 +75,26 @@ public:
 	virtual void ProcessInput(const uint8_t* keyState) {}
 	// Called when world transform changes
 	virtual void OnUpdateWorldTransform();
+	// Called when the owner is recycled (or reused), to remove the
+	// component from (or add it back to) any systems it's in
+	virtual void OnRecycle();
+	virtual void OnReuse();
 
 	class Actor* GetOwner() { return mOwner; }
 	int GetUpdateOrder() const { return mUpdateOrder; }
 
 	virtual TypeID GetType() const = 0;
 
+	// Where this component is in the ComponentRegistry
+	// (-1 if it isn't in an update list)
+	int GetRegistryBucket() const { return mRegistryBucket; }
+	int GetRegistryIndex() const { return mRegistryIndex; }
+	void SetRegistryIndex(int bucket, int index) { mRegistryBucket = bucket; mRegistryIndex = index; }
+	// Index in the list of whichever system this component is part of
+	// (renderer, physics or HUD), or -1 if it isn't in one
+	int GetSystemIndex() const { return mSystemIndex; }
+	void SetSystemIndex(int index) { mSystemIndex = index; }
+
 	// Load/Save
 	virtual void LoadProperties(const rapidjson::Value& inObj);
 	virtual void SaveProperties(rapidjson::Document::AllocatorType& alloc,
@@ -66,9 +110,18 @@ public:
 		t->LoadProperties(inObj);
 		return t;
 	}
+
+	// Components are allocated from size-class pools
+	static void* operator new(size_t size) { return PoolAllocator::Allocate(size); }
+	static void operator delete(void* ptr, size_t size) { PoolAllocator::Free(ptr, size); }
 protected:
 	// Owning actor
 	class Actor* mOwner;
 	// Update order of component
 	int mUpdateOrder;
+	// Location in the ComponentRegistry
+	int mRegistryBucket;
+	int mRegistryIndex;
+	// Location in a system's list
+	int mSystemIndex;
 };
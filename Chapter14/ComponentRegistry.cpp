@@ -0,0 +1,187 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "ComponentRegistry.h"
+#include "Profiler.h"
+#include "Actor.h"
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace
+{
+	// Components updated per job, for types that update in parallel
+	const size_t ComponentsPerJob = 32;
+}
+
+ComponentRegistry::ComponentRegistry(JobSystem* jobs)
+	:mUpdating(false)
+	,mJobs(jobs)
+{
+}
+
+void ComponentRegistry::Register(Component* comp)
+{
+	mPending.emplace_back(comp);
+}
+
+void ComponentRegistry::Unregister(Component* comp)
+{
+	int bucketIndex = comp->GetRegistryBucket();
+	if (bucketIndex < 0)
+	{
+		// Never made it out of pending (or never updates)
+		auto iter = std::find(mPending.begin(), mPending.end(), comp);
+		if (iter != mPending.end())
+		{
+			// Swap to end of vector and pop off (avoid erase copies)
+			std::iter_swap(iter, mPending.end() - 1);
+			mPending.pop_back();
+		}
+		return;
+	}
+
+	Bucket& bucket = mBuckets[bucketIndex];
+	int index = comp->GetRegistryIndex();
+	if (mUpdating)
+	{
+		// Don't change the list while it's being iterated,
+		// just null out this entry for now
+		bucket.mComponents[index] = nullptr;
+		bucket.mHasNulls = true;
+	}
+	else
+	{
+		// Swap to end of vector and pop off
+		Component* last = bucket.mComponents.back();
+		bucket.mComponents[index] = last;
+		last->SetRegistryIndex(bucketIndex, index);
+		bucket.mComponents.pop_back();
+	}
+	comp->SetRegistryIndex(-1, -1);
+}
+
+void ComponentRegistry::Update(Component::UpdateStage stage, float deltaTime)
+{
+	AddPending();
+
+	mUpdating = true;
+	for (int bucketIndex : mBucketOrder)
+	{
+		Component::TypeID type = mBuckets[bucketIndex].mType;
+		if (Component::TypeStages[type] != stage)
+		{
+			continue;
+		}
+
+		// (Components added during this loop are pending,
+		// so the list can't grow underneath us)
+		std::vector<Component*>& comps = mBuckets[bucketIndex].mComponents;
+		auto updateRange = [&comps, type, deltaTime](size_t begin, size_t end) {
+			PROFILE_SCOPE(Component::TypeNames[type]);
+			for (size_t i = begin; i < end; i++)
+			{
+				Component* comp = comps[i];
+				if (comp && comp->GetOwner()->GetState() == Actor::EActive)
+				{
+					comp->Update(deltaTime);
+				}
+			}
+		};
+
+		if (mJobs && !(Component::TypeAccess[type] & Component::AWriteWorld))
+		{
+			// These only write to their own actor, so it's
+			// safe to update them all at once
+			mJobs->ParallelFor(comps.size(), ComponentsPerJob, updateRange);
+		}
+		else
+		{
+			updateRange(0, comps.size());
+		}
+	}
+	mUpdating = false;
+
+	RemoveNulls();
+}
+
+void ComponentRegistry::AddPending()
+{
+	for (Component* comp : mPending)
+	{
+		Component::TypeID type = comp->GetType();
+		// Skip types that never do anything in Update
+		if (!Component::TypeUpdates[type])
+		{
+			continue;
+		}
+
+		// Find the bucket for this update order and type
+		int order = comp->GetUpdateOrder();
+		auto iter = mBucketOrder.begin();
+		for (; iter != mBucketOrder.end(); ++iter)
+		{
+			const Bucket& b = mBuckets[*iter];
+			if (b.mUpdateOrder > order ||
+				(b.mUpdateOrder == order && b.mType >= type))
+			{
+				break;
+			}
+		}
+
+		int bucketIndex = 0;
+		if (iter != mBucketOrder.end() &&
+			mBuckets[*iter].mUpdateOrder == order &&
+			mBuckets[*iter].mType == type)
+		{
+			bucketIndex = *iter;
+		}
+		else
+		{
+			// First of its kind, so make a new bucket
+			bucketIndex = static_cast<int>(mBuckets.size());
+			Bucket b;
+			b.mUpdateOrder = order;
+			b.mType = type;
+			b.mHasNulls = false;
+			mBuckets.emplace_back(b);
+			mBucketOrder.insert(iter, bucketIndex);
+		}
+
+		std::vector<Component*>& comps = mBuckets[bucketIndex].mComponents;
+		comp->SetRegistryIndex(bucketIndex, static_cast<int>(comps.size()));
+		comps.emplace_back(comp);
+	}
+	mPending.clear();
+}
+
+void ComponentRegistry::RemoveNulls()
+{
+	for (int bucketIndex = 0; bucketIndex < static_cast<int>(mBuckets.size()); bucketIndex++)
+	{
+		Bucket& bucket = mBuckets[bucketIndex];
+		if (!bucket.mHasNulls)
+		{
+			continue;
+		}
+
+		// Slide the remaining components down, fixing up their indices
+		std::vector<Component*>& comps = bucket.mComponents;
+		size_t write = 0;
+		for (size_t read = 0; read < comps.size(); read++)
+		{
+			if (comps[read])
+			{
+				comps[write] = comps[read];
+				comps[write]->SetRegistryIndex(bucketIndex, static_cast<int>(write));
+				write++;
+			}
+		}
+		comps.resize(write);
+		bucket.mHasNulls = false;
+	}
+}
@@ -0,0 +1,53 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include "Component.h"
+
+// Keeps every component that needs to update in a list per
+// (update order, type), so each type updates in one tight pass
+class ComponentRegistry
+{
+public:
+	ComponentRegistry(class JobSystem* jobs);
+
+	// Components register when created, but aren't actually added
+	// to a list until the next Update (once they're fully constructed)
+	void Register(class Component* comp);
+	void Unregister(class Component* comp);
+
+	// Update all components in the stage with an active owner
+	// (types that don't write to the world are split across threads)
+	void Update(Component::UpdateStage stage, float deltaTime);
+	// Add all pending components to their lists (Update does this
+	// too, but call it on the main thread before an Update that runs
+	// in a job, so the job only walks lists that are already built)
+	void AddPending();
+private:
+	// Remove any components unregistered during Update
+	void RemoveNulls();
+
+	struct Bucket
+	{
+		int mUpdateOrder;
+		Component::TypeID mType;
+		std::vector<class Component*> mComponents;
+		// Whether any entries were nulled out during Update
+		bool mHasNulls;
+	};
+	// Buckets never move (components remember their bucket index)
+	std::vector<Bucket> mBuckets;
+	// Bucket indices, sorted by update order then type
+	std::vector<int> mBucketOrder;
+	// Components waiting to be added to their bucket
+	std::vector<class Component*> mPending;
+	// Track if we're updating components right now
+	bool mUpdating;
+	class JobSystem* mJobs;
+};
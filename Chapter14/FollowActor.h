@@ -22,7 +22,8 @@ public:
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
 
-	TypeID GetType() const override { return TFollowActor; }
+	static const TypeID StaticType = TFollowActor;
+	TypeID GetType() const override { return StaticType; }
 private:
 	class MoveComponent* mMoveComp;
 	class FollowCamera* mCameraComp;
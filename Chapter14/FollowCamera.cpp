@@ -36,8 +36,8 @@ void FollowCamera::Update(float deltaTime)
 	// Update actual camera position
 	mActualPos += mVelocity * deltaTime;
 	// Target is target dist in front of owning actor
-	Vector3 target = mOwner->GetPosition() +
-		mOwner->GetForward() * mTargetDist;
+	Vector3 target = mOwner->GetWorldPosition() +
+		mOwner->GetWorldForward() * mTargetDist;
 	// Use actual position here, not ideal
 	Matrix4 view = Matrix4::CreateLookAt(mActualPos, target,
 		Vector3::UnitZ);
@@ -51,8 +51,8 @@ void FollowCamera::SnapToIdeal()
 	// Zero velocity
 	mVelocity = Vector3::Zero;
 	// Compute target and view
-	Vector3 target = mOwner->GetPosition() +
-		mOwner->GetForward() * mTargetDist;
+	Vector3 target = mOwner->GetWorldPosition() +
+		mOwner->GetWorldForward() * mTargetDist;
 	// Use actual position here, not ideal
 	Matrix4 view = Matrix4::CreateLookAt(mActualPos, target,
 		Vector3::UnitZ);
@@ -86,8 +86,8 @@ void FollowCamera::SaveProperties(rapidjson::Document::AllocatorType& alloc, rap
 Vector3 FollowCamera::ComputeCameraPos() const
 {
 	// Set camera position behind and above owner
-	Vector3 cameraPos = mOwner->GetPosition();
-	cameraPos -= mOwner->GetForward() * mHorzDist;
+	Vector3 cameraPos = mOwner->GetWorldPosition();
+	cameraPos -= mOwner->GetWorldForward() * mHorzDist;
 	cameraPos += Vector3::UnitZ * mVertDist;
 	return cameraPos;
 }
@@ -8,11 +8,61 @@
 
 #include "Font.h"
 #include "Texture.h"
+#include "TextureAtlas.h"
+#include "SpriteBatch.h"
 #include <vector>
+#include <cmath>
+#include <algorithm>
 #include "Game.h"
 
+namespace
+{
+	// Reads the next character from UTF-8 text
+	// (returning U+FFFD for anything malformed)
+	uint32_t DecodeUTF8(const std::string& text, size_t& i)
+	{
+		unsigned char c = static_cast<unsigned char>(text[i++]);
+		int extra = 0;
+		uint32_t ch = 0;
+		if (c < 0x80)
+		{
+			return c;
+		}
+		else if ((c & 0xe0) == 0xc0)
+		{
+			extra = 1;
+			ch = c & 0x1f;
+		}
+		else if ((c & 0xf0) == 0xe0)
+		{
+			extra = 2;
+			ch = c & 0x0f;
+		}
+		else if ((c & 0xf8) == 0xf0)
+		{
+			extra = 3;
+			ch = c & 0x07;
+		}
+		else
+		{
+			return 0xfffd;
+		}
+		for (int j = 0; j < extra; j++)
+		{
+			if (i >= text.size() ||
+				(static_cast<unsigned char>(text[i]) & 0xc0) != 0x80)
+			{
+				return 0xfffd;
+			}
+			ch = (ch << 6) | (static_cast<unsigned char>(text[i++]) & 0x3f);
+		}
+		return ch;
+	}
+}
+
 Font::Font(class Game* game)
-	:mGame(game)
+	:mAtlas(nullptr)
+	,mGame(game)
 {
 	
 }
@@ -24,72 +74,197 @@ Font::~Font()
 
 bool Font::Load(const std::string& fileName)
 {
-	// We support these font sizes
-	std::vector<int> fontSizes = {
-		8, 9,
-		10, 11, 12, 14, 16, 18,
-		20, 22, 24, 26, 28,
-		30, 32, 34, 36, 38,
-		40, 42, 44, 46, 48,
-		52, 56,
-		60, 64, 68,
-		72
-	};
-	
-	for (auto& size : fontSizes)
+	// SDL_ttf isn't initialized in headless mode
+	if (mGame->IsHeadless())
 	{
-		TTF_Font* font = TTF_OpenFont(fileName.c_str(), size);
-		if (font == nullptr)
-		{
-			SDL_Log("Failed to load font %s in size %d", fileName.c_str(), size);
-			return false;
-		}
-		mFontData.emplace(size, font);
+		return true;
+	}
+
+	// Point sizes are opened the first time they're used,
+	// so just make sure the font opens at the default size
+	mFileName = fileName;
+	if (GetSizeData(30) == nullptr)
+	{
+		return false;
 	}
+	mAtlas = new TextureAtlas();
+	mAtlas->SetPageSize(512);
 	return true;
 }
 
 void Font::Unload()
 {
-	for (auto& font : mFontData)
+	for (auto& size : mSizes)
 	{
-		TTF_CloseFont(font.second);
+		TTF_CloseFont(size.second->mFont);
+		delete size.second;
+	}
+	mSizes.clear();
+	if (mAtlas)
+	{
+		mAtlas->Unload();
+		delete mAtlas;
+		mAtlas = nullptr;
 	}
 }
 
-Texture* Font::RenderText(const std::string& textKey,
-						  const Vector3& color /*= Color::White*/,
-						  int pointSize /*= 24*/)
+void Font::DrawString(SpriteBatch* batch, const std::string& textKey,
+					  const Vector2& pos,
+					  const Vector3& color /*= Color::White*/,
+					  int pointSize /*= 30*/)
 {
-	Texture* texture = nullptr;
-	
-	// Convert to SDL_Color
-	SDL_Color sdlColor;
-	sdlColor.r = static_cast<Uint8>(color.x * 255);
-	sdlColor.g = static_cast<Uint8>(color.y * 255);
-	sdlColor.b = static_cast<Uint8>(color.z * 255);
-	sdlColor.a = 255;
-	
-	// Find the font data for this point size
-	auto iter = mFontData.find(pointSize);
-	if (iter != mFontData.end())
+	SizeData* data = GetSizeData(pointSize);
+	if (data == nullptr)
+	{
+		return;
+	}
+
+	// Lay out the glyphs along the line, with kerning
+	const std::string& actualText = mGame->GetText(textKey);
+	bool kerning = TTF_GetFontKerning(data->mFont) != 0;
+	mLayout.clear();
+	int penX = 0;
+	int prevIndex = 0;
+	size_t i = 0;
+	while (i < actualText.size())
 	{
-		TTF_Font* font = iter->second;
-		const std::string& actualText = mGame->GetText(textKey);
-		// Draw this to a surface (blended for alpha)
-		SDL_Surface* surf = TTF_RenderUTF8_Blended(font, actualText.c_str(), sdlColor);
-		if (surf != nullptr)
+		// (SDL_ttf only has glyphs for 16-bit characters)
+		uint32_t ch = DecodeUTF8(actualText, i);
+		const Glyph* glyph = GetGlyph(data, pointSize, ch <= 0xffff ?
+			static_cast<uint16_t>(ch) : 0xfffd);
+		if (kerning && prevIndex != 0 && glyph->mIndex != 0)
 		{
-			// Convert from surface to texture
-			texture = new Texture();
-			texture->CreateFromSurface(surf);
-			SDL_FreeSurface(surf);
+			penX += TTF_GetFontKerningSize(data->mFont, prevIndex, glyph->mIndex);
 		}
+		PlacedGlyph placed;
+		placed.mGlyph = glyph;
+		placed.mX = penX;
+		mLayout.emplace_back(placed);
+		penX += glyph->mAdvance;
+		prevIndex = glyph->mIndex;
 	}
-	else
+
+	// Center the line on pos, snapped to whole pixels so it stays sharp
+	float left = std::floor(pos.x - penX * 0.5f);
+	float top = std::floor(pos.y + TTF_FontHeight(data->mFont) * 0.5f);
+	for (const PlacedGlyph& placed : mLayout)
 	{
-		SDL_Log("Point size %d is unsupported", pointSize);
+		const Glyph* glyph = placed.mGlyph;
+		if (glyph->mTexture == nullptr)
+		{
+			continue;
+		}
+		float width = static_cast<float>(glyph->mTexture->GetWidth());
+		float height = static_cast<float>(glyph->mTexture->GetHeight());
+		Vector3 center(left + placed.mX + glyph->mMinX + width * 0.5f,
+			top - glyph->mTop - height * 0.5f, 0.0f);
+		Matrix4 world = Matrix4::CreateScale(width, height, 1.0f) *
+			Matrix4::CreateTranslation(center);
+		batch->Draw(glyph->mTexture, world, Vector2::Zero, Vector2(1.0f, 1.0f),
+			color);
 	}
-	
-	return texture;
+}
+
+Font::SizeData* Font::GetSizeData(int pointSize)
+{
+	auto iter = mSizes.find(pointSize);
+	if (iter != mSizes.end())
+	{
+		return iter->second;
+	}
+
+	TTF_Font* font = TTF_OpenFont(mFileName.c_str(), pointSize);
+	if (font == nullptr)
+	{
+		SDL_Log("Failed to load font %s in size %d", mFileName.c_str(), pointSize);
+		return nullptr;
+	}
+	SizeData* data = new SizeData();
+	data->mFont = font;
+	mSizes.emplace(pointSize, data);
+	return data;
+}
+
+const Font::Glyph* Font::GetGlyph(SizeData* data, int pointSize, uint16_t ch)
+{
+	auto iter = data->mGlyphs.find(ch);
+	if (iter != data->mGlyphs.end())
+	{
+		return &iter->second;
+	}
+
+	Glyph glyph;
+	glyph.mTexture = nullptr;
+	glyph.mMinX = 0;
+	glyph.mTop = 0;
+	glyph.mAdvance = 0;
+	glyph.mIndex = 0;
+	int minX = 0;
+	int maxX = 0;
+	int minY = 0;
+	int maxY = 0;
+	if (TTF_GlyphMetrics(data->mFont, ch, &minX, &maxX, &minY, &maxY,
+		&glyph.mAdvance) != 0)
+	{
+		// Remember it's missing, so it's skipped from now on
+		return &data->mGlyphs.emplace(ch, glyph).first->second;
+	}
+	glyph.mIndex = TTF_GlyphIsProvided(data->mFont, ch);
+
+	// Render the glyph in white (text is tinted when it's drawn).
+	// The surface is the glyph's whole cell (starting at the pen
+	// position and the top of the line, with the glyph already at its
+	// bearing), so crop it to the pixels actually used, and remember
+	// where they were in the cell
+	SDL_Color white = { 255, 255, 255, 255 };
+	SDL_Surface* surf = TTF_RenderGlyph_Blended(data->mFont, ch, white);
+	if (surf != nullptr)
+	{
+		std::vector<unsigned char> cell(surf->w * surf->h * 4);
+		int left = surf->w;
+		int right = -1;
+		int top = surf->h;
+		int bottom = -1;
+		SDL_LockSurface(surf);
+		for (int y = 0; y < surf->h; y++)
+		{
+			const Uint32* row = reinterpret_cast<const Uint32*>(
+				static_cast<const Uint8*>(surf->pixels) + y * surf->pitch);
+			unsigned char* dst = &cell[y * surf->w * 4];
+			for (int x = 0; x < surf->w; x++)
+			{
+				SDL_GetRGBA(row[x], surf->format, &dst[0], &dst[1], &dst[2], &dst[3]);
+				if (dst[3] != 0)
+				{
+					left = std::min(left, x);
+					right = std::max(right, x);
+					top = std::min(top, y);
+					bottom = std::max(bottom, y);
+				}
+				dst += 4;
+			}
+		}
+		SDL_UnlockSurface(surf);
+
+		// (Nothing to pack for glyphs with no pixels, like spaces)
+		if (right >= left)
+		{
+			int width = right - left + 1;
+			int height = bottom - top + 1;
+			std::vector<unsigned char> pixels(width * height * 4);
+			for (int y = 0; y < height; y++)
+			{
+				const unsigned char* src = &cell[((top + y) * surf->w + left) * 4];
+				std::copy(src, src + width * 4, &pixels[y * width * 4]);
+			}
+			glyph.mMinX = left;
+			glyph.mTop = top;
+			std::string name = mFileName + ":" + std::to_string(pointSize) +
+				":" + std::to_string(ch);
+			glyph.mTexture = mAtlas->Add(name, width, height, pixels.data());
+		}
+		SDL_FreeSurface(surf);
+	}
+
+	return &data->mGlyphs.emplace(ch, glyph).first->second;
 }
@@ -8,6 +8,8 @@
 
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <unordered_map>
 #include <SDL/SDL_ttf.h>
 #include "Math.h"
@@ -17,17 +19,57 @@ class Font
 public:
 	Font(class Game* game);
 	~Font();
-	
+
 	// Load/unload from a file
 	bool Load(const std::string& fileName);
 	void Unload();
-	
-	// Given string and this font, draw to a texture
-	class Texture* RenderText(const std::string& textKey,
-							  const Vector3& color = Color::White,
-							  int pointSize = 30);
+
+	// Given string and this font, add quads for each of its
+	// glyphs to the batch (centered on pos)
+	void DrawString(class SpriteBatch* batch, const std::string& textKey,
+				    const Vector2& pos,
+				    const Vector3& color = Color::White,
+				    int pointSize = 30);
 private:
+	// A character rendered at one point size
+	struct Glyph
+	{
+		// Where it's packed in the atlas
+		// (nullptr for glyphs with nothing to draw, like spaces)
+		class Texture* mTexture;
+		// Offset of the image from the pen position/top of the line
+		// (where it was cropped out of the rendered glyph's cell)
+		int mMinX;
+		int mTop;
+		int mAdvance;
+		// Index in the font, for kerning
+		int mIndex;
+	};
+
+	// Font data for one point size
+	struct SizeData
+	{
+		TTF_Font* mFont;
+		std::unordered_map<uint16_t, Glyph> mGlyphs;
+	};
+
+	// Opens this point size the first time it's used
+	SizeData* GetSizeData(int pointSize);
+	// Rasterizes this glyph the first time it's used
+	const Glyph* GetGlyph(SizeData* data, int pointSize, uint16_t ch);
+
+	// Glyph and its x in the text, while laying out text
+	struct PlacedGlyph
+	{
+		const Glyph* mGlyph;
+		int mX;
+	};
+
+	std::string mFileName;
 	// Map of point sizes to font data
-	std::unordered_map<int, TTF_Font*> mFontData;
+	std::unordered_map<int, SizeData*> mSizes;
+	// Every rasterized glyph, for every size
+	class TextureAtlas* mAtlas;
+	std::vector<PlacedGlyph> mLayout;
 	class Game* mGame;
 };
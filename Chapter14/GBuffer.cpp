@@ -12,6 +12,7 @@
 
 GBuffer::GBuffer()
 	:mBufferID(0)
+	,mLayout(EWorldPosLayout)
 {
 	
 }
@@ -21,36 +22,61 @@ GBuffer::~GBuffer()
 	
 }
 
-bool GBuffer::Create(int width, int height)
+bool GBuffer::Create(int width, int height, Layout layout)
 {
+	mLayout = layout;
 	// Create the framebuffer object
 	glGenFramebuffers(1, &mBufferID);
 	glBindFramebuffer(GL_FRAMEBUFFER, mBufferID);
 	
-	// Add a depth buffer to this target
-	GLuint depthBuffer;
-	glGenRenderbuffers(1, &depthBuffer);
-	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT,
-						  width, height);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-							  GL_RENDERBUFFER, depthBuffer);
-	
-	// Create textures for each output in the G-buffer
-	for (int i = 0; i < NUM_GBUFFER_TEXTURES; i++)
+	int numColorTextures = NUM_GBUFFER_TEXTURES;
+	if (mLayout == ECompactLayout)
+	{
+		// Diffuse (with spec power in alpha) and normal
+		const GLenum formats[] = { GL_RGBA8, GL_RG16 };
+		numColorTextures = 2;
+		for (int i = 0; i < numColorTextures; i++)
+		{
+			Texture* tex = new Texture();
+			tex->CreateForRendering(width, height, formats[i]);
+			mTextures.emplace_back(tex);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+								 tex->GetTextureID(), 0);
+		}
+		// The depth buffer is a texture, so it can be sampled
+		Texture* depth = new Texture();
+		depth->CreateForRendering(width, height, GL_DEPTH_COMPONENT24);
+		mTextures.emplace_back(depth);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+							 depth->GetTextureID(), 0);
+	}
+	else
 	{
-		Texture* tex = new Texture();
-		// We want three 32-bit float components for each texture
-		tex->CreateForRendering(width, height, GL_RGB32F);
-		mTextures.emplace_back(tex);
-		// Attach this texture to a color output
-		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
-							 tex->GetTextureID(), 0);
+		// Add a depth buffer to this target
+		GLuint depthBuffer;
+		glGenRenderbuffers(1, &depthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT,
+							  width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+								  GL_RENDERBUFFER, depthBuffer);
+		
+		// Create textures for each output in the G-buffer
+		for (int i = 0; i < NUM_GBUFFER_TEXTURES; i++)
+		{
+			Texture* tex = new Texture();
+			// We want three 32-bit float components for each texture
+			tex->CreateForRendering(width, height, GL_RGB32F);
+			mTextures.emplace_back(tex);
+			// Attach this texture to a color output
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+								 tex->GetTextureID(), 0);
+		}
 	}
 	
 	// Create a vector of the color attachments
 	std::vector<GLenum> attachments;
-	for (int i = 0; i < NUM_GBUFFER_TEXTURES; i++)
+	for (int i = 0; i < numColorTextures; i++)
 	{
 		attachments.emplace_back(GL_COLOR_ATTACHMENT0 + i);
 	}
@@ -18,15 +18,28 @@ public:
 		EDiffuse = 0,
 		ENormal,
 		EWorldPos,
-		NUM_GBUFFER_TEXTURES
+		NUM_GBUFFER_TEXTURES,
+		// The compact layout has depth where world position would be
+		EDepth = EWorldPos
+	};
+
+	// How the data is stored
+	enum Layout
+	{
+		// 32-bit float RGB diffuse, normal and world position
+		EWorldPosLayout,
+		// RGBA8 diffuse + spec power, RG16 octahedral normal, and
+		// a 24-bit depth texture to rebuild world position from
+		ECompactLayout
 	};
 
 	GBuffer();
 	~GBuffer();
 
 	// Create/destroy the G-buffer
-	bool Create(int width, int height);
+	bool Create(int width, int height, Layout layout = EWorldPosLayout);
 	void Destroy();
+	Layout GetLayout() const { return mLayout; }
 	
 	// Get the texture for a specific type of data
 	class Texture* GetTexture(Type type);
@@ -39,4 +52,5 @@ private:
 	std::vector<class Texture*> mTextures;
 	// Frame buffer object ID
 	unsigned int mBufferID;
+	Layout mLayout;
 };
@@ -28,25 +28,73 @@
 #include "Animation.h"
 #include "PointLightComponent.h"
 #include "LevelLoader.h"
+#include "TransformStore.h"
+#include "ComponentRegistry.h"
+#include "JobSystem.h"
+#include "TaskGraph.h"
+#include "CommandBuffer.h"
+#include "Profiler.h"
+#include <thread>
+
+namespace
+{
+	// Longest frame we'll try to catch up on (e.g. after a breakpoint)
+	const float MaxFrameTime = 0.25f;
+	// Most simulation ticks to run in a single frame
+	const int MaxTicksPerFrame = 8;
+	// Actors updated per job in the parallel actor update
+	const size_t ActorsPerJob = 64;
+}
 
 Game::Game()
 :mRenderer(nullptr)
 ,mAudioSystem(nullptr)
 ,mPhysWorld(nullptr)
+,mTransforms(nullptr)
+,mComponentRegistry(nullptr)
+,mJobSystem(nullptr)
+,mCommands(nullptr)
+,mFrameGraph(nullptr)
+,mFrameCounter(0)
+,mSimTimeStep(1.0f / 60.0f)
+,mAccumulator(0.0f)
+,mFrameTime(0.0f)
+,mTickedTime(0.0f)
+,mMaxFrameRate(60)
 ,mGameState(EGameplay)
 ,mUpdatingActors(false)
+,mHeadless(false)
+,mCompactGBuffer(false)
+,mRenderThread(true)
 {
 	
 }
 
-bool Game::Initialize()
+bool Game::Initialize(bool headless, bool compactGBuffer, bool renderThread)
 {
-	if (SDL_Init(SDL_INIT_VIDEO|SDL_INIT_AUDIO) != 0)
+	mHeadless = headless;
+	mCompactGBuffer = compactGBuffer;
+	mRenderThread = renderThread;
+	// Headless doesn't need video or audio, just events/timers
+	Uint32 sdlFlags = SDL_INIT_VIDEO|SDL_INIT_AUDIO;
+	if (mHeadless)
+	{
+		sdlFlags = SDL_INIT_TIMER|SDL_INIT_EVENTS;
+		// Don't cap the frame rate, simulate as fast as we can
+		mMaxFrameRate = 0;
+	}
+	if (SDL_Init(sdlFlags) != 0)
 	{
 		SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
 		return false;
 	}
 
+	// Start the worker threads
+	mJobSystem = new JobSystem();
+	mJobSystem->Initialize();
+	SDL_Log("Job system running on %d threads", mJobSystem->GetNumThreads());
+	mCommands = new CommandBuffer(mJobSystem->GetNumThreads());
+
 	// Create the renderer
 	mRenderer = new Renderer(this);
 	if (!mRenderer->Initialize(1024.0f, 768.0f))
@@ -70,9 +118,14 @@ bool Game::Initialize()
 
 	// Create the physics world
 	mPhysWorld = new PhysWorld(this);
+
+	// Create the store for all actor transforms
+	mTransforms = new TransformStore(mJobSystem);
+	// Create the update lists for all components
+	mComponentRegistry = new ComponentRegistry(mJobSystem);
 	
-	// Initialize SDL_ttf
-	if (TTF_Init() != 0)
+	// Initialize SDL_ttf (fonts don't render in headless mode)
+	if (!mHeadless && TTF_Init() != 0)
 	{
 		SDL_Log("Failed to initialize SDL_ttf");
 		return false;
@@ -80,23 +133,37 @@ bool Game::Initialize()
 
 	LoadData();
 
-	mTicksCount = SDL_GetTicks();
+	BuildFrameGraph();
+
+	mFrameCounter = SDL_GetPerformanceCounter();
 	
 	return true;
 }
 
-void Game::RunLoop()
+void Game::RunLoop(int numFrames)
 {
-	while (mGameState != EQuit)
+	Uint64 startCounter = SDL_GetPerformanceCounter();
+	int frame = 0;
+	while (mGameState != EQuit && (numFrames < 0 || frame < numFrames))
 	{
+		Profiler::BeginFrame();
 		ProcessInput();
 		UpdateGame();
 		GenerateOutput();
+		frame++;
+	}
+
+	if (mHeadless)
+	{
+		float seconds = static_cast<float>(SDL_GetPerformanceCounter() -
+			startCounter) / SDL_GetPerformanceFrequency();
+		SDL_Log("Simulated %d frames in %f seconds", frame, seconds);
 	}
 }
 
 void Game::ProcessInput()
 {
+	PROFILE_SCOPE("Game::ProcessInput");
 	SDL_Event event;
 	while (SDL_PollEvent(&event))
 	{
@@ -195,6 +262,12 @@ void Game::HandleKeyPress(int key)
 		LevelLoader::SaveLevel(this, "Assets/Saved.gplevel");
 		break;
 	}
+	case 'p':
+	{
+		// Dump the last couple seconds of profiling
+		Profiler::DumpChromeTrace("profile.json", 120);
+		break;
+	}
 	case SDL_BUTTON_LEFT:
 	{
 		break;
@@ -206,32 +279,119 @@ void Game::HandleKeyPress(int key)
 
 void Game::UpdateGame()
 {
-	// Compute delta time
-	// Wait until 16ms has elapsed since last frame
-	while (!SDL_TICKS_PASSED(SDL_GetTicks(), mTicksCount + 16))
-		;
+	PROFILE_SCOPE("Game::UpdateGame");
+	// Headless mode doesn't care about real time, and always
+	// advances by exactly one tick per frame
+	float frameTime = mSimTimeStep;
+	if (!mHeadless)
+	{
+		// Sleep until the frame limiter lets us start the next frame
+		WaitForNextFrame();
+
+		// Compute how much real time elapsed since last frame
+		Uint64 counter = SDL_GetPerformanceCounter();
+		frameTime = static_cast<float>(counter - mFrameCounter) /
+			SDL_GetPerformanceFrequency();
+		mFrameCounter = counter;
+		if (frameTime > MaxFrameTime)
+		{
+			frameTime = MaxFrameTime;
+		}
+	}
 
-	float deltaTime = (SDL_GetTicks() - mTicksCount) / 1000.0f;
-	if (deltaTime > 0.05f)
+	// Simulate in fixed steps until we've caught up with real time
+	mAccumulator += frameTime;
+	// (Only ticks that simulate count toward mTickedTime, so
+	// animations hold while paused)
+	mTickedTime = 0.0f;
+	int numTicks = 0;
+	while (mAccumulator >= mSimTimeStep && numTicks < MaxTicksPerFrame)
+	{
+		TickSimulation(mSimTimeStep);
+		mAccumulator -= mSimTimeStep;
+		numTicks++;
+	}
+	// If we still can't keep up, drop the whole ticks we skipped
+	if (mAccumulator >= mSimTimeStep)
 	{
-		deltaTime = 0.05f;
+		mAccumulator = Math::Fmod(mAccumulator, mSimTimeStep);
 	}
-	mTicksCount = SDL_GetTicks();
 
+	// Run audio, UI, animation and render prep (overlapping
+	// wherever they don't depend on each other)
+	mFrameTime = frameTime;
+	mComponentRegistry->AddPending();
+	mFrameGraph->Run();
+
+	// Delete any UIScreens that are closed
+	auto iter = mUIStack.begin();
+	while (iter != mUIStack.end())
+	{
+		if ((*iter)->GetState() == UIScreen::EClosing)
+		{
+			delete *iter;
+			iter = mUIStack.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+void Game::TickSimulation(float deltaTime)
+{
+	PROFILE_SCOPE("Game::TickSimulation");
 	if (mGameState == EGameplay)
 	{
-		// Update all actors
+		mTickedTime += deltaTime;
+
+		// Compute world transforms of anything moved since last tick
+		mTransforms->ComputeWorldTransforms();
+
+		// Remember where everything was at the start of this tick,
+		// so rendering can interpolate toward the new state
+		mTransforms->SaveHistory();
+		mRenderer->SaveViewHistory();
+
+		// Update all components, one pass per update order and type
+		// (animation is only needed for drawing, so it's done once
+		// per frame in the frame graph instead)
 		mUpdatingActors = true;
+		mComponentRegistry->Update(Component::EGameplayStage, deltaTime);
+		// Then any actor-specific updates, first the types that
+		// only touch themselves (in parallel), then the rest
+		// (so not in the order actors were added)
+		mJobSystem->ParallelFor(mActors.size(), ActorsPerJob,
+			[this, deltaTime](size_t begin, size_t end) {
+			PROFILE_SCOPE("Actor::Update");
+			for (size_t i = begin; i < end; i++)
+			{
+				Actor* actor = mActors[i];
+				if (!(Actor::TypeAccess[actor->GetType()] & Component::AWriteWorld))
+				{
+					actor->Update(deltaTime);
+				}
+			}
+		});
 		for (auto actor : mActors)
 		{
-			actor->Update(deltaTime);
+			if (Actor::TypeAccess[actor->GetType()] & Component::AWriteWorld)
+			{
+				actor->Update(deltaTime);
+			}
 		}
+		// Now that nothing is updating, apply anything deferred
+		mCommands->Apply();
 		mUpdatingActors = false;
 
 		// Move any pending actors to mActors
 		for (auto pending : mPendingActors)
 		{
 			pending->ComputeWorldTransform();
+			ActorSlot& slot = mActorSlots[pending->GetHandle().mIndex];
+			slot.mIndex = static_cast<int>(mActors.size());
+			slot.mPending = false;
 			mActors.emplace_back(pending);
 		}
 		mPendingActors.clear();
@@ -246,45 +406,125 @@ void Game::UpdateGame()
 			}
 		}
 
-		// Delete dead actors (which removes them from mActors)
+		// Delete (or recycle) dead actors, which removes them from mActors
 		for (auto actor : deadActors)
 		{
-			delete actor;
+			if (actor->IsRecyclable())
+			{
+				actor->Recycle();
+			}
+			else
+			{
+				delete actor;
+			}
 		}
 	}
-	
-	// Update audio system
-	mAudioSystem->Update(deltaTime);
-	
-	// Update UI screens
-	for (auto ui : mUIStack)
+}
+
+void Game::WaitForNextFrame()
+{
+	PROFILE_SCOPE("Game::WaitForNextFrame");
+	if (mMaxFrameRate <= 0)
 	{
-		if (ui->GetState() == UIScreen::EActive)
-		{
-			ui->Update(deltaTime);
-		}
+		return;
 	}
-	// Delete any UIScreens that are closed
-	auto iter = mUIStack.begin();
-	while (iter != mUIStack.end())
+
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 target = mFrameCounter + frequency / mMaxFrameRate;
+	Uint64 counter = SDL_GetPerformanceCounter();
+	while (counter < target)
 	{
-		if ((*iter)->GetState() == UIScreen::EClosing)
+		// SDL_Delay only has millisecond granularity, so sleep for
+		// all but the last millisecond and yield for the remainder
+		Uint64 remainingMs = (target - counter) * 1000 / frequency;
+		if (remainingMs > 1)
 		{
-			delete *iter;
-			iter = mUIStack.erase(iter);
+			SDL_Delay(static_cast<Uint32>(remainingMs - 1));
 		}
 		else
 		{
-			++iter;
+			std::this_thread::yield();
 		}
+		counter = SDL_GetPerformanceCounter();
 	}
 }
 
 void Game::GenerateOutput()
 {
+	PROFILE_SCOPE("Game::GenerateOutput");
+	// Nothing to draw in headless mode
+	if (mHeadless)
+	{
+		return;
+	}
+
+	// (Render transforms were computed in the frame graph)
 	mRenderer->Draw();
 }
 
+void Game::BuildFrameGraph()
+{
+	mFrameGraph = new TaskGraph(mJobSystem);
+
+	// Update world transforms of anything moved since the last tick,
+	// so physics queries and audio see where things are now
+	// (on the main thread, since owners are informed as well)
+	int transforms = mFrameGraph->AddTask("Transforms", [this]() {
+		mTransforms->ComputeWorldTransforms();
+	}, true);
+
+	// Audio doesn't depend on anything else in the frame
+	int audio = mFrameGraph->AddTask("Audio", [this]() {
+		mAudioSystem->Update(mFrameTime);
+	});
+	mFrameGraph->AddDependency(transforms, audio);
+
+	// UI screens can reach into anything, so they stay on the main thread
+	int uiUpdate = mFrameGraph->AddTask("UI", [this]() {
+		for (auto ui : mUIStack)
+		{
+			if (ui->GetState() == UIScreen::EActive)
+			{
+				ui->Update(mFrameTime);
+			}
+		}
+		// (Anything the UI created is added before animation starts)
+		mComponentRegistry->AddPending();
+	}, true);
+	mFrameGraph->AddDependency(transforms, uiUpdate);
+
+	// Advance animations by however much was simulated this frame,
+	// and compute their matrix palettes (split across workers).
+	// This is after the UI, since nothing else can touch the component
+	// registry while it's updating on a worker
+	int animation = mFrameGraph->AddTask("Animation", [this]() {
+		if (mTickedTime > 0.0f)
+		{
+			mComponentRegistry->Update(Component::EAnimationStage, mTickedTime);
+		}
+	});
+	mFrameGraph->AddDependency(transforms, animation);
+	mFrameGraph->AddDependency(uiUpdate, animation);
+
+	if (!mHeadless)
+	{
+		// Blend between the last two simulation ticks based on how far
+		// we are into the next one (while paused, hold the latest state)
+		int renderPrep = mFrameGraph->AddTask("RenderPrep", [this]() {
+			float alpha = 1.0f;
+			if (mGameState == EGameplay)
+			{
+				alpha = mAccumulator / mSimTimeStep;
+			}
+			mTransforms->ComputeRenderTransforms(alpha);
+			mRenderer->ComputeRenderView(alpha);
+		});
+		mFrameGraph->AddDependency(transforms, renderPrep);
+		// (So the frame goes transforms, then palettes, then render prep)
+		mFrameGraph->AddDependency(animation, renderPrep);
+	}
+}
+
 void Game::LoadData()
 {
 	// Load English text
@@ -298,10 +538,13 @@ void Game::LoadData()
 	// Start music
 	mMusicEvent = mAudioSystem->PlayEvent("event:/Music");
 
-	// Enable relative mouse mode for camera look
-	SDL_SetRelativeMouseMode(SDL_TRUE);
-	// Make an initial call to get relative to clear out
-	SDL_GetRelativeMouseState(nullptr, nullptr);
+	if (!mHeadless)
+	{
+		// Enable relative mouse mode for camera look
+		SDL_SetRelativeMouseMode(SDL_TRUE);
+		// Make an initial call to get relative to clear out
+		SDL_GetRelativeMouseState(nullptr, nullptr);
+	}
 }
 
 void Game::UnloadData()
@@ -312,6 +555,14 @@ void Game::UnloadData()
 	{
 		delete mActors.back();
 	}
+	for (auto& r : mRecycledActors)
+	{
+		for (auto actor : r.second)
+		{
+			delete actor;
+		}
+	}
+	mRecycledActors.clear();
 
 	// Clear the UI stack
 	while (!mUIStack.empty())
@@ -348,7 +599,14 @@ void Game::UnloadData()
 void Game::Shutdown()
 {
 	UnloadData();
-	TTF_Quit();
+	if (!mHeadless)
+	{
+		TTF_Quit();
+	}
+	delete mFrameGraph;
+	delete mCommands;
+	delete mComponentRegistry;
+	delete mTransforms;
 	delete mPhysWorld;
 	if (mRenderer)
 	{
@@ -358,41 +616,105 @@ void Game::Shutdown()
 	{
 		mAudioSystem->Shutdown();
 	}
+	if (mJobSystem)
+	{
+		mJobSystem->Shutdown();
+		delete mJobSystem;
+	}
 	SDL_Quit();
 }
 
 void Game::AddActor(Actor* actor)
 {
+	// Find a free slot for the actor's handle
+	uint32_t slotIndex = 0;
+	if (!mFreeActorSlots.empty())
+	{
+		slotIndex = mFreeActorSlots.back();
+		mFreeActorSlots.pop_back();
+	}
+	else
+	{
+		slotIndex = static_cast<uint32_t>(mActorSlots.size());
+		ActorSlot newSlot;
+		// (Start at 1, since generation 0 means a null handle)
+		newSlot.mGeneration = 1;
+		mActorSlots.emplace_back(newSlot);
+	}
+	ActorSlot& slot = mActorSlots[slotIndex];
+	slot.mActor = actor;
+	actor->SetHandle(ActorHandle(slotIndex, slot.mGeneration));
+
 	// If we're updating actors, need to add to pending
-	if (mUpdatingActors)
+	slot.mPending = mUpdatingActors;
+	if (slot.mPending)
 	{
+		slot.mIndex = static_cast<int>(mPendingActors.size());
 		mPendingActors.emplace_back(actor);
 	}
 	else
 	{
+		slot.mIndex = static_cast<int>(mActors.size());
 		mActors.emplace_back(actor);
 	}
 }
 
 void Game::RemoveActor(Actor* actor)
 {
-	// Is it in pending actors?
-	auto iter = std::find(mPendingActors.begin(), mPendingActors.end(), actor);
-	if (iter != mPendingActors.end())
+	ActorHandle handle = actor->GetHandle();
+	if (GetActor(handle) != actor)
 	{
-		// Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mPendingActors.end() - 1);
-		mPendingActors.pop_back();
+		return;
 	}
 
-	// Is it in actors?
-	iter = std::find(mActors.begin(), mActors.end(), actor);
-	if (iter != mActors.end())
+	ActorSlot& slot = mActorSlots[handle.mIndex];
+	std::vector<Actor*>& actors = slot.mPending ? mPendingActors : mActors;
+	// Swap the last actor into this one's place and pop off
+	Actor* last = actors.back();
+	actors[slot.mIndex] = last;
+	mActorSlots[last->GetHandle().mIndex].mIndex = slot.mIndex;
+	actors.pop_back();
+
+	// Free the slot, and bump the generation so old handles are invalid
+	slot.mActor = nullptr;
+	slot.mGeneration++;
+	if (slot.mGeneration == 0)
+	{
+		slot.mGeneration = 1;
+	}
+	mFreeActorSlots.emplace_back(handle.mIndex);
+	actor->SetHandle(ActorHandle());
+}
+
+Actor* Game::GetActor(const ActorHandle& handle) const
+{
+	Actor* actor = nullptr;
+	if (handle.mIndex < mActorSlots.size())
+	{
+		const ActorSlot& slot = mActorSlots[handle.mIndex];
+		if (slot.mGeneration == handle.mGeneration)
+		{
+			actor = slot.mActor;
+		}
+	}
+	return actor;
+}
+
+void Game::AddRecycledActor(Actor* actor)
+{
+	mRecycledActors[actor->GetType()].emplace_back(actor);
+}
+
+Actor* Game::TakeRecycledActor(int type)
+{
+	Actor* actor = nullptr;
+	auto iter = mRecycledActors.find(type);
+	if (iter != mRecycledActors.end() && !iter->second.empty())
 	{
-		// Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mActors.end() - 1);
-		mActors.pop_back();
+		actor = iter->second.back();
+		iter->second.pop_back();
 	}
+	return actor;
 }
 
 void Game::PushUI(UIScreen* screen)
@@ -12,23 +12,43 @@
 #include <vector>
 #include "Math.h"
 #include "SoundEvent.h"
+#include "ActorHandle.h"
 #include <SDL/SDL_types.h>
 
 class Game
 {
 public:
 	Game();
-	bool Initialize();
-	void RunLoop();
+	// Headless runs the simulation without a window, GL or audio.
+	// compactGBuffer picks the smaller G-buffer layout
+	// (see GBuffer::Layout). renderThread submits GL on its own
+	// thread, overlapped with the next frame's simulation
+	bool Initialize(bool headless = false, bool compactGBuffer = false,
+		bool renderThread = true);
+	// Run until quit, or for numFrames frames if non-negative
+	void RunLoop(int numFrames = -1);
 	void Shutdown();
 
 	void AddActor(class Actor* actor);
 	void RemoveActor(class Actor* actor);
+	// Returns null if the actor no longer exists
+	class Actor* GetActor(const ActorHandle& handle) const;
+
+	// Recycled actors, by Actor::TypeID
+	void AddRecycledActor(class Actor* actor);
+	class Actor* TakeRecycledActor(int type);
 
 	class Renderer* GetRenderer() { return mRenderer; }
 	class AudioSystem* GetAudioSystem() { return mAudioSystem; }
 	class PhysWorld* GetPhysWorld() { return mPhysWorld; }
 	class HUD* GetHUD() { return mHUD; }
+	class TransformStore* GetTransforms() { return mTransforms; }
+	class ComponentRegistry* GetComponentRegistry() { return mComponentRegistry; }
+	// Commands recorded during parallel updates (actors can't be
+	// created, and other actors or systems can't be changed, until
+	// the commands are applied at the end of the update)
+	class CommandBuffer* GetCommands() { return mCommands; }
+	class JobSystem* GetJobSystem() { return mJobSystem; }
 	
 	// Manage UI stack
 	const std::vector<class UIScreen*>& GetUIStack() { return mUIStack; }
@@ -45,6 +65,10 @@ public:
 	
 	GameState GetState() const { return mGameState; }
 	void SetState(GameState state) { mGameState = state; }
+
+	bool IsHeadless() const { return mHeadless; }
+	bool UseCompactGBuffer() const { return mCompactGBuffer; }
+	bool UseRenderThread() const { return mRenderThread; }
 	
 	class Font* GetFont(const std::string& fileName);
 
@@ -57,10 +81,23 @@ public:
 
 	const std::vector<class Actor*>& GetActors() const { return mActors; }
 	void SetFollowActor(class FollowActor* actor) { mFollowActor = actor; }
+
+	// Fixed simulation rate (ticks per second)
+	void SetSimTickRate(float ticksPerSecond) { mSimTimeStep = 1.0f / ticksPerSecond; }
+	float GetSimTimeStep() const { return mSimTimeStep; }
+	// Cap on rendered frames per second (0 for no limit)
+	void SetMaxFrameRate(int framesPerSecond) { mMaxFrameRate = framesPerSecond; }
+	int GetMaxFrameRate() const { return mMaxFrameRate; }
 private:
 	void ProcessInput();
 	void HandleKeyPress(int key);
 	void UpdateGame();
+	// Advance the simulation by one fixed step
+	void TickSimulation(float deltaTime);
+	// Sleep until it's time to start the next frame
+	void WaitForNextFrame();
+	// Set up the tasks run once per frame after the simulation ticks
+	void BuildFrameGraph();
 	void GenerateOutput();
 	void LoadData();
 	void UnloadData();
@@ -79,16 +116,47 @@ private:
 	std::unordered_map<std::string, std::string> mText;
 	// Any pending actors
 	std::vector<class Actor*> mPendingActors;
+	// Table of actors by handle
+	struct ActorSlot
+	{
+		class Actor* mActor;
+		uint32_t mGeneration;
+		// Index in mActors (or mPendingActors, if pending)
+		int mIndex;
+		bool mPending;
+	};
+	std::vector<ActorSlot> mActorSlots;
+	std::vector<uint32_t> mFreeActorSlots;
+	// Dead actors kept around for reuse, by type
+	std::unordered_map<int, std::vector<class Actor*>> mRecycledActors;
 
 	class Renderer* mRenderer;
 	class AudioSystem* mAudioSystem;
 	class PhysWorld* mPhysWorld;
 	class HUD* mHUD;
+	class TransformStore* mTransforms;
+	class ComponentRegistry* mComponentRegistry;
+	class JobSystem* mJobSystem;
+	class CommandBuffer* mCommands;
+	class TaskGraph* mFrameGraph;
 
-	Uint32 mTicksCount;
+	// Performance counter value at the start of the last frame
+	Uint64 mFrameCounter;
+	// Length of a simulation tick, in seconds
+	float mSimTimeStep;
+	// Time that has elapsed but not been simulated yet
+	float mAccumulator;
+	// Real time and simulated time for the current frame
+	// (no time is simulated while paused)
+	float mFrameTime;
+	float mTickedTime;
+	int mMaxFrameRate;
 	GameState mGameState;
 	// Track if we're updating actors right now
 	bool mUpdatingActors;
+	bool mHeadless;
+	bool mCompactGBuffer;
+	bool mRenderThread;
 
 	// Game-specific code
 	class FollowActor* mFollowActor;
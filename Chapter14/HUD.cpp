@@ -8,7 +8,7 @@
 
 #include "HUD.h"
 #include "Texture.h"
-#include "Shader.h"
+#include "SpriteBatch.h"
 #include "Game.h"
 #include "Renderer.h"
 #include "PhysWorld.h"
@@ -44,42 +44,50 @@ void HUD::Update(float deltaTime)
 	UpdateRadar(deltaTime);
 }
 
-void HUD::Draw(Shader* shader)
+void HUD::Draw(SpriteBatch* batch)
 {
 	// Crosshair
 	//Texture* cross = mTargetEnemy ? mCrosshairEnemy : mCrosshair;
-	//DrawTexture(shader, cross, Vector2::Zero, 2.0f);
+	//DrawTexture(batch, cross, Vector2::Zero, 2.0f);
 	
 	// Radar
 	const Vector2 cRadarPos(-390.0f, 275.0f);
-	DrawTexture(shader, mRadar, cRadarPos, 1.0f);
+	DrawTexture(batch, mRadar, cRadarPos, 1.0f);
 	// Blips
 	for (Vector2& blip : mBlips)
 	{
-		DrawTexture(shader, mBlipTex, cRadarPos + blip, 1.0f);
+		DrawTexture(batch, mBlipTex, cRadarPos + blip, 1.0f);
 	}
 	// Radar arrow
-	DrawTexture(shader, mRadarArrow, cRadarPos);
+	DrawTexture(batch, mRadarArrow, cRadarPos);
 	
 	//// Health bar
-	//DrawTexture(shader, mHealthBar, Vector2(-350.0f, -350.0f));
+	//DrawTexture(batch, mHealthBar, Vector2(-350.0f, -350.0f));
 	// Draw the mirror (bottom left)
 	//Texture* mirror = mGame->GetRenderer()->GetMirrorTexture();
-	//DrawTexture(shader, mirror, Vector2(-350.0f, -250.0f), 1.0f, true);
+	//DrawTexture(batch, mirror, Vector2(-350.0f, -250.0f), 1.0f, true);
 	//Texture* tex = mGame->GetRenderer()->GetGBuffer()->GetTexture(GBuffer::EDiffuse);
-	//DrawTexture(shader, tex, Vector2::Zero, 1.0f, true);
+	//DrawTexture(batch, tex, Vector2::Zero, 1.0f, true);
 }
 
 void HUD::AddTargetComponent(TargetComponent* tc)
 {
+	tc->SetSystemIndex(static_cast<int>(mTargetComps.size()));
 	mTargetComps.emplace_back(tc);
 }
 
 void HUD::RemoveTargetComponent(TargetComponent* tc)
 {
-	auto iter = std::find(mTargetComps.begin(), mTargetComps.end(),
-		tc);
-	mTargetComps.erase(iter);
+	int index = tc->GetSystemIndex();
+	if (index >= 0)
+	{
+		// Swap the last target into this one's place and pop off
+		TargetComponent* last = mTargetComps.back();
+		mTargetComps[index] = last;
+		last->SetSystemIndex(index);
+		mTargetComps.pop_back();
+		tc->SetSystemIndex(-1);
+	}
 }
 
 void HUD::UpdateCrosshair(float deltaTime)
@@ -113,10 +121,10 @@ void HUD::UpdateRadar(float deltaTime)
 	mBlips.clear();
 	
 	// Convert player position to radar coordinates (x forward, z up)
-	Vector3 playerPos = mGame->GetPlayer()->GetPosition();
+	Vector3 playerPos = mGame->GetPlayer()->GetWorldPosition();
 	Vector2 playerPos2D(playerPos.y, playerPos.x);
 	// Ditto for player forward
-	Vector3 playerForward = mGame->GetPlayer()->GetForward();
+	Vector3 playerForward = mGame->GetPlayer()->GetWorldForward();
 	Vector2 playerForward2D(playerForward.x, playerForward.y);
 	
 	// Use atan2 to get rotation of radar
@@ -127,7 +135,7 @@ void HUD::UpdateRadar(float deltaTime)
 	// Get positions of blips
 	for (auto tc : mTargetComps)
 	{
-		Vector3 targetPos = tc->GetOwner()->GetPosition();
+		Vector3 targetPos = tc->GetOwner()->GetWorldPosition();
 		Vector2 actorPos2D(targetPos.y, targetPos.x);
 		
 		// Calculate vector between player and target
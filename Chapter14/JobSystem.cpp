@@ -0,0 +1,244 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "JobSystem.h"
+
+namespace
+{
+	// Which queue the current thread uses
+	thread_local int sThreadIndex = 0;
+}
+
+JobSystem::JobSystem()
+	:mNumQueuedJobs(0)
+	,mRunning(false)
+{
+}
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+void JobSystem::Initialize(int numWorkers)
+{
+	if (numWorkers < 0)
+	{
+		// Leave one hardware thread for the main thread
+		numWorkers = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+		if (numWorkers < 0)
+		{
+			numWorkers = 0;
+		}
+	}
+
+	// Main thread gets queue 0
+	sThreadIndex = 0;
+	mQueues.emplace_back(new JobQueue());
+	for (int i = 0; i < numWorkers; i++)
+	{
+		mQueues.emplace_back(new JobQueue());
+	}
+
+	mRunning = true;
+	for (int i = 0; i < numWorkers; i++)
+	{
+		mThreads.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+	}
+}
+
+void JobSystem::Shutdown()
+{
+	if (mRunning)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mWakeMutex);
+			mRunning = false;
+		}
+		mWakeCondition.notify_all();
+		for (auto& t : mThreads)
+		{
+			t.join();
+		}
+		mThreads.clear();
+	}
+
+	for (auto q : mQueues)
+	{
+		delete q;
+	}
+	mQueues.clear();
+}
+
+void JobSystem::Run(const Job& job, JobCounter* counter)
+{
+	if (counter)
+	{
+		counter->mCount++;
+	}
+
+	// Without any queues (not initialized), just run it now
+	if (mQueues.empty())
+	{
+		job();
+		if (counter)
+		{
+			counter->mCount--;
+		}
+		return;
+	}
+
+	JobQueue* queue = mQueues[sThreadIndex];
+	{
+		std::lock_guard<std::mutex> lock(queue->mMutex);
+		queue->mJobs.push_back({ job, counter });
+	}
+	mNumQueuedJobs++;
+
+	// Wake up a sleeping worker to take it
+	if (!mThreads.empty())
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mWakeCondition.notify_one();
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		// Help out instead of just spinning
+		if (!RunOneJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::RunOneJob()
+{
+	if (mQueues.empty())
+	{
+		return false;
+	}
+
+	JobEntry entry;
+	if (TryGetJob(sThreadIndex, entry))
+	{
+		Execute(entry);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::ParallelFor(size_t count, size_t batchSize,
+	const std::function<void(size_t, size_t)>& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (batchSize == 0)
+	{
+		batchSize = 1;
+	}
+
+	// Not worth splitting up if it all fits in one batch
+	// (or there's nobody else to help)
+	if (count <= batchSize || mThreads.empty())
+	{
+		func(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (size_t begin = 0; begin < count; begin += batchSize)
+	{
+		size_t end = begin + batchSize;
+		if (end > count)
+		{
+			end = count;
+		}
+		Run([&func, begin, end]() {
+			func(begin, end);
+		}, &counter);
+	}
+	Wait(counter);
+}
+
+int JobSystem::GetThreadIndex()
+{
+	return sThreadIndex;
+}
+
+void JobSystem::WorkerLoop(int threadIndex)
+{
+	sThreadIndex = threadIndex;
+	while (mRunning)
+	{
+		JobEntry entry;
+		if (TryGetJob(threadIndex, entry))
+		{
+			Execute(entry);
+		}
+		else
+		{
+			// Nothing to do, so sleep until a job is queued
+			std::unique_lock<std::mutex> lock(mWakeMutex);
+			mWakeCondition.wait(lock, [this]() {
+				return !mRunning || mNumQueuedJobs.load() > 0;
+			});
+		}
+	}
+}
+
+bool JobSystem::TryGetJob(int threadIndex, JobEntry& outEntry)
+{
+	if (mNumQueuedJobs.load() == 0)
+	{
+		return false;
+	}
+
+	// Newest job from our own queue first (it's most likely in cache)
+	JobQueue* queue = mQueues[threadIndex];
+	{
+		std::lock_guard<std::mutex> lock(queue->mMutex);
+		if (!queue->mJobs.empty())
+		{
+			outEntry = std::move(queue->mJobs.back());
+			queue->mJobs.pop_back();
+			mNumQueuedJobs--;
+			return true;
+		}
+	}
+
+	// Otherwise steal the oldest job from another queue
+	size_t numQueues = mQueues.size();
+	for (size_t i = 1; i < numQueues; i++)
+	{
+		JobQueue* victim = mQueues[(threadIndex + i) % numQueues];
+		std::lock_guard<std::mutex> lock(victim->mMutex);
+		if (!victim->mJobs.empty())
+		{
+			outEntry = std::move(victim->mJobs.front());
+			victim->mJobs.pop_front();
+			mNumQueuedJobs--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::Execute(JobEntry& entry)
+{
+	entry.mJob();
+	if (entry.mCounter)
+	{
+		entry.mCounter->mCount--;
+	}
+}
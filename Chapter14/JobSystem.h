@@ -0,0 +1,89 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Tracks how many jobs in a group haven't finished yet
+class JobCounter
+{
+public:
+	JobCounter() :mCount(0) {}
+	bool IsDone() const { return mCount.load() == 0; }
+private:
+	friend class JobSystem;
+	std::atomic<int> mCount;
+};
+
+// Runs jobs on a pool of worker threads. Each thread has its own
+// queue, and threads that run out of work steal from the others
+class JobSystem
+{
+public:
+	typedef std::function<void()> Job;
+
+	JobSystem();
+	~JobSystem();
+
+	// Start the worker threads (-1 for one per extra hardware thread)
+	void Initialize(int numWorkers = -1);
+	void Shutdown();
+
+	// Queue a job on the calling thread's queue
+	// (if counter isn't null, it's incremented until the job finishes)
+	void Run(const Job& job, JobCounter* counter = nullptr);
+	// Wait for all jobs on the counter to finish (this thread runs
+	// other jobs while it waits, rather than blocking)
+	void Wait(JobCounter& counter);
+	// Try to run one queued job on the calling thread
+	// Returns true if it ran a job
+	bool RunOneJob();
+
+	// Call func(begin, end) over [0, count), split into jobs of
+	// batchSize elements, and wait for them all to finish
+	void ParallelFor(size_t count, size_t batchSize,
+		const std::function<void(size_t, size_t)>& func);
+
+	// Number of threads running jobs (workers plus the main thread)
+	int GetNumThreads() const { return static_cast<int>(mQueues.size()); }
+	// Index of the calling thread (0 is the main thread)
+	static int GetThreadIndex();
+private:
+	struct JobEntry
+	{
+		Job mJob;
+		JobCounter* mCounter;
+	};
+
+	struct JobQueue
+	{
+		std::deque<JobEntry> mJobs;
+		std::mutex mMutex;
+	};
+
+	void WorkerLoop(int threadIndex);
+	// Pop from the back of our own queue, or steal from the front
+	// of someone else's
+	bool TryGetJob(int threadIndex, JobEntry& outEntry);
+	void Execute(JobEntry& entry);
+
+	// One queue per thread (index 0 is the main thread)
+	std::vector<JobQueue*> mQueues;
+	std::vector<std::thread> mThreads;
+	// Idle workers sleep on this until there's something to do
+	std::mutex mWakeMutex;
+	std::condition_variable mWakeCondition;
+	std::atomic<int> mNumQueuedJobs;
+	std::atomic<bool> mRunning;
+};
@@ -7,8 +7,10 @@
 // ----------------------------------------------------------------
 
 #include "LevelLoader.h"
+#include "Profiler.h"
 #include <fstream>
 #include <vector>
+#include <unordered_map>
 #include <SDL/SDL.h>
 #include "Game.h"
 #include "Renderer.h"
@@ -63,6 +65,7 @@ std::unordered_map<std::string, std::pair<int, ComponentFunc>> LevelLoader::sCom
 
 bool LevelLoader::LoadLevel(Game* game, const std::string& fileName)
 {
+	PROFILE_SCOPE("LevelLoader::LoadLevel");
 	rapidjson::Document doc;
 	if (!LoadJSON(fileName, doc))
 	{
@@ -183,6 +186,9 @@ void LevelLoader::LoadGlobalProperties(Game* game, const rapidjson::Value& inObj
 
 void LevelLoader::LoadActors(Game* game, const rapidjson::Value& inArray)
 {
+	// Actors in the order they appear in the array (null if not
+	// loaded), so parents can be looked up by their index
+	std::vector<Actor*> loaded(inArray.Size(), nullptr);
 	// Loop through array of actors
 	for (rapidjson::SizeType i = 0; i < inArray.Size(); i++)
 	{
@@ -199,6 +205,7 @@ void LevelLoader::LoadActors(Game* game, const rapidjson::Value& inArray)
 				{
 					// Construct with function stored in map
 					Actor* actor = iter->second(game, actorObj["properties"]);
+					loaded[i] = actor;
 					// Get the actor's components
 					if (actorObj.HasMember("components"))
 					{
@@ -216,6 +223,24 @@ void LevelLoader::LoadActors(Game* game, const rapidjson::Value& inArray)
 			}
 		}
 	}
+
+	// Now that every actor exists, attach any children
+	for (rapidjson::SizeType i = 0; i < inArray.Size(); i++)
+	{
+		int parent = -1;
+		if (loaded[i] && inArray[i].IsObject() &&
+			JsonHelper::GetInt(inArray[i], "parent", parent))
+		{
+			if (parent >= 0 && parent < static_cast<int>(loaded.size()) && loaded[parent])
+			{
+				loaded[i]->SetParent(loaded[parent]);
+			}
+			else
+			{
+				SDL_Log("Invalid parent %d for actor %d", parent, i);
+			}
+		}
+	}
 }
 
 void LevelLoader::LoadComponents(Actor* actor, const rapidjson::Value& inArray)
@@ -276,12 +301,25 @@ void LevelLoader::SaveActors(rapidjson::Document::AllocatorType& alloc,
 	Game* game, rapidjson::Value& inArray)
 {
 	const auto& actors = game->GetActors();
+	// Index of each actor in the array (children refer to their parent by index)
+	std::unordered_map<const Actor*, int> indices;
+	for (size_t i = 0; i < actors.size(); i++)
+	{
+		indices.emplace(actors[i], static_cast<int>(i));
+	}
+
 	for (const Actor* actor : actors)
 	{
 		// Make a JSON object
 		rapidjson::Value obj(rapidjson::kObjectType);
 		// Add type
 		JsonHelper::AddString(alloc, obj, "type", Actor::TypeNames[actor->GetType()]);
+		// Add parent, if there is one
+		auto parentIter = indices.find(actor->GetParent());
+		if (parentIter != indices.end())
+		{
+			JsonHelper::AddInt(alloc, obj, "parent", parentIter->second);
+		}
 
 		// Make object for properties
 		rapidjson::Value props(rapidjson::kObjectType);
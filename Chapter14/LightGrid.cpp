@@ -0,0 +1,244 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "LightGrid.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include "PointLightComponent.h"
+#include "Actor.h"
+#include <GL/glew.h>
+#include <cstring>
+
+namespace
+{
+	// Lights to find tile rects for per job
+	const size_t LightsPerJob = 64;
+
+	// Upload data to a texture buffer (never empty, since
+	// a buffer texture needs some storage)
+	template <typename T>
+	void UploadBuffer(unsigned int buffer, const std::vector<T>& data)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+		if (data.empty())
+		{
+			T zero[4] = {};
+			glBufferData(GL_TEXTURE_BUFFER, sizeof(zero), zero, GL_STREAM_DRAW);
+		}
+		else
+		{
+			glBufferData(GL_TEXTURE_BUFFER, data.size() * sizeof(T),
+				data.data(), GL_STREAM_DRAW);
+		}
+	}
+
+	void CreateBuffer(unsigned int& buffer, unsigned int& texture, GLenum format)
+	{
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+		glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_BUFFER, texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+	}
+}
+
+LightGrid::LightGrid()
+	:mWidth(0)
+	,mHeight(0)
+	,mTilesX(0)
+	,mTilesY(0)
+	,mLightBuffer(0)
+	,mLightTexture(0)
+	,mTileBuffer(0)
+	,mTileTexture(0)
+	,mIndexBuffer(0)
+	,mIndexTexture(0)
+{
+}
+
+LightGrid::~LightGrid()
+{
+}
+
+bool LightGrid::Create(int width, int height)
+{
+	mWidth = width;
+	mHeight = height;
+	mTilesX = (width + TileSize - 1) / TileSize;
+	mTilesY = (height + TileSize - 1) / TileSize;
+	mRowIndices.resize(mTilesY);
+
+	CreateBuffer(mLightBuffer, mLightTexture, GL_RGBA32F);
+	CreateBuffer(mTileBuffer, mTileTexture, GL_RG32UI);
+	CreateBuffer(mIndexBuffer, mIndexTexture, GL_R32UI);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	return glGetError() == GL_NO_ERROR;
+}
+
+void LightGrid::Destroy()
+{
+	glDeleteTextures(1, &mLightTexture);
+	glDeleteBuffers(1, &mLightBuffer);
+	glDeleteTextures(1, &mTileTexture);
+	glDeleteBuffers(1, &mTileBuffer);
+	glDeleteTextures(1, &mIndexTexture);
+	glDeleteBuffers(1, &mIndexBuffer);
+}
+
+void LightGrid::Update(const std::vector<PointLightComponent*>& lights,
+	const Matrix4& view, const Matrix4& proj, JobSystem* jobs, Lists& outLists)
+{
+	PROFILE_SCOPE("LightGrid::Update");
+	// Find the light data and the tiles each light covers
+	size_t numLights = lights.size();
+	outLists.mLightData.resize(numLights * 8);
+	outLists.mTileData.resize(mTilesX * mTilesY * 2);
+	mLightRects.resize(numLights);
+	jobs->ParallelFor(numLights, LightsPerJob, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+		{
+			PointLightComponent* p = lights[i];
+			const Matrix4& world = p->GetOwner()->GetRenderTransform();
+			Vector3 worldPos = world.GetTranslation();
+			float* data = &outLists.mLightData[i * 8];
+			data[0] = worldPos.x;
+			data[1] = worldPos.y;
+			data[2] = worldPos.z;
+			data[3] = p->mInnerRadius;
+			data[4] = p->mDiffuseColor.x;
+			data[5] = p->mDiffuseColor.y;
+			data[6] = p->mDiffuseColor.z;
+			data[7] = p->mOuterRadius;
+			// (Same volume as the one it was culled with)
+			mLightRects[i] = ComputeTileRect(Vector3::Transform(worldPos, view),
+				p->mOuterRadius * world.GetScale().x, proj);
+		}
+	});
+
+	// Each row of tiles is binned separately
+	jobs->ParallelFor(static_cast<size_t>(mTilesY), 1, [this, &outLists](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; y++)
+		{
+			BinRow(static_cast<int>(y), outLists);
+		}
+	});
+
+	// Join the rows into one list
+	std::vector<uint32_t>& indices = outLists.mLightIndices;
+	indices.clear();
+	for (int y = 0; y < mTilesY; y++)
+	{
+		uint32_t rowStart = static_cast<uint32_t>(indices.size());
+		uint32_t* tile = &outLists.mTileData[y * mTilesX * 2];
+		for (int x = 0; x < mTilesX; x++)
+		{
+			tile[x * 2] += rowStart;
+		}
+		indices.insert(indices.end(), mRowIndices[y].begin(), mRowIndices[y].end());
+	}
+}
+
+void LightGrid::Upload(const Lists& lists)
+{
+	PROFILE_SCOPE("LightGrid::Upload");
+	UploadBuffer(mLightBuffer, lists.mLightData);
+	UploadBuffer(mTileBuffer, lists.mTileData);
+	UploadBuffer(mIndexBuffer, lists.mLightIndices);
+}
+
+LightGrid::TileRect LightGrid::ComputeTileRect(const Vector3& viewPos,
+	float radius, const Matrix4& proj) const
+{
+	TileRect rect;
+	rect.mMinX = 0;
+	rect.mMinY = 0;
+	rect.mMaxX = mTilesX - 1;
+	rect.mMaxY = mTilesY - 1;
+	// If the camera is inside the sphere, it could cover everything
+	float nearZ = viewPos.z - radius;
+	float farZ = viewPos.z + radius;
+	if (nearZ <= 0.0f)
+	{
+		return rect;
+	}
+
+	// Bound the projection of the sphere's bounding box
+	// (x/z over the box is smallest/largest at its corners)
+	float minX = Math::Min((viewPos.x - radius) / nearZ, (viewPos.x - radius) / farZ);
+	float maxX = Math::Max((viewPos.x + radius) / nearZ, (viewPos.x + radius) / farZ);
+	float minY = Math::Min((viewPos.y - radius) / nearZ, (viewPos.y - radius) / farZ);
+	float maxY = Math::Max((viewPos.y + radius) / nearZ, (viewPos.y + radius) / farZ);
+	// To normalized device coordinates, then to tiles
+	// (y = 0 is the bottom row, same as gl_FragCoord)
+	float toTilesX = mWidth * 0.5f / TileSize;
+	float toTilesY = mHeight * 0.5f / TileSize;
+	rect.mMinX = static_cast<int>(Math::Max(minX * proj.mat[0][0] + 1.0f, 0.0f) * toTilesX);
+	rect.mMaxX = static_cast<int>(Math::Max(maxX * proj.mat[0][0] + 1.0f, 0.0f) * toTilesX);
+	rect.mMinY = static_cast<int>(Math::Max(minY * proj.mat[1][1] + 1.0f, 0.0f) * toTilesY);
+	rect.mMaxY = static_cast<int>(Math::Max(maxY * proj.mat[1][1] + 1.0f, 0.0f) * toTilesY);
+	rect.mMaxX = Math::Min(rect.mMaxX, mTilesX - 1);
+	rect.mMaxY = Math::Min(rect.mMaxY, mTilesY - 1);
+	return rect;
+}
+
+void LightGrid::BinRow(int y, Lists& lists)
+{
+	uint32_t* tiles = &lists.mTileData[y * mTilesX * 2];
+	memset(tiles, 0, mTilesX * 2 * sizeof(uint32_t));
+
+	// Count the lights in each tile
+	for (const TileRect& rect : mLightRects)
+	{
+		if (y >= rect.mMinY && y <= rect.mMaxY)
+		{
+			for (int x = rect.mMinX; x <= rect.mMaxX; x++)
+			{
+				tiles[x * 2 + 1]++;
+			}
+		}
+	}
+
+	// Offsets from the counts
+	uint32_t total = 0;
+	for (int x = 0; x < mTilesX; x++)
+	{
+		tiles[x * 2] = total;
+		total += tiles[x * 2 + 1];
+	}
+
+	// Then fill in the lists (using the counts as write positions)
+	std::vector<uint32_t>& indices = mRowIndices[y];
+	indices.resize(total);
+	for (int x = 0; x < mTilesX; x++)
+	{
+		tiles[x * 2 + 1] = 0;
+	}
+	for (size_t i = 0; i < mLightRects.size(); i++)
+	{
+		const TileRect& rect = mLightRects[i];
+		if (y >= rect.mMinY && y <= rect.mMaxY)
+		{
+			for (int x = rect.mMinX; x <= rect.mMaxX; x++)
+			{
+				indices[tiles[x * 2] + tiles[x * 2 + 1]++] = static_cast<uint32_t>(i);
+			}
+		}
+	}
+}
+
+void LightGrid::SetTexturesActive()
+{
+	glActiveTexture(GL_TEXTURE0 + ELightsUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, mLightTexture);
+	glActiveTexture(GL_TEXTURE0 + ETilesUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, mTileTexture);
+	glActiveTexture(GL_TEXTURE0 + ELightIndicesUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, mIndexTexture);
+	glActiveTexture(GL_TEXTURE0);
+}
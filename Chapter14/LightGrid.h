@@ -0,0 +1,94 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Math.h"
+
+// Splits the screen into tiles, and lists which point lights touch
+// each tile, so a single full screen pass can light every pixel
+// with just the lights that reach it. The lists are in texture
+// buffers, read with texelFetch in GBufferGlobal.frag
+class LightGrid
+{
+public:
+	// Width/height of a tile in pixels
+	static const int TileSize = 16;
+
+	// Texture units the buffers are bound to (after the G-buffer's)
+	enum Unit
+	{
+		ELightsUnit = 3,
+		ETilesUnit,
+		ELightIndicesUnit
+	};
+
+	// Everything uploaded for a frame
+	struct Lists
+	{
+		// Two texels per light: world pos + inner radius,
+		// and diffuse color + outer radius
+		std::vector<float> mLightData;
+		// Offset into mLightIndices and light count, per tile
+		std::vector<uint32_t> mTileData;
+		std::vector<uint32_t> mLightIndices;
+	};
+
+	LightGrid();
+	~LightGrid();
+
+	// Create/destroy the buffers, for a screen of this size
+	bool Create(int width, int height);
+	void Destroy();
+
+	// Bin the lights into tiles for this view
+	// (split across jobs, and without touching GL)
+	void Update(const std::vector<class PointLightComponent*>& lights,
+		const Matrix4& view, const Matrix4& proj, class JobSystem* jobs,
+		Lists& outLists);
+	// Upload the binned lists to the buffers
+	void Upload(const Lists& lists);
+	// Bind the buffers to their texture units
+	void SetTexturesActive();
+
+	int GetNumTilesX() const { return mTilesX; }
+	int GetNumTilesY() const { return mTilesY; }
+private:
+	// Range of tiles a light covers (inclusive, empty if min > max)
+	struct TileRect
+	{
+		int mMinX;
+		int mMinY;
+		int mMaxX;
+		int mMaxY;
+	};
+
+	TileRect ComputeTileRect(const Vector3& viewPos, float radius,
+		const Matrix4& proj) const;
+	// Bin every light into tile row y
+	void BinRow(int y, Lists& lists);
+
+	int mWidth;
+	int mHeight;
+	int mTilesX;
+	int mTilesY;
+
+	std::vector<TileRect> mLightRects;
+	// Light indices for each row of tiles (with offsets in mTileData
+	// relative to the row), before they're joined into mLightIndices
+	std::vector<std::vector<uint32_t>> mRowIndices;
+
+	// GL buffer and buffer texture for each list
+	unsigned int mLightBuffer;
+	unsigned int mLightTexture;
+	unsigned int mTileBuffer;
+	unsigned int mTileTexture;
+	unsigned int mIndexBuffer;
+	unsigned int mIndexTexture;
+};
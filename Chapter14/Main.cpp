@@ -7,14 +7,56 @@
 // ----------------------------------------------------------------
 
 #include "Game.h"
+#include "Profiler.h"
+#include <cstdlib>
+#include <cstring>
 
 int main(int argc, char** argv)
 {
+	// Command line options:
+	// -headless: simulate without a window, GL or audio
+	// -frames N: quit after N frames
+	// -profile file: on exit, write a Chrome trace of the last frames
+	// -compactgbuffer: use the compact G-buffer layout
+	// -norenderthread: submit GL on the main thread
+	bool headless = false;
+	bool compactGBuffer = false;
+	bool renderThread = true;
+	int numFrames = -1;
+	const char* profileFile = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-headless") == 0)
+		{
+			headless = true;
+		}
+		else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			numFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc)
+		{
+			profileFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "-compactgbuffer") == 0)
+		{
+			compactGBuffer = true;
+		}
+		else if (strcmp(argv[i], "-norenderthread") == 0)
+		{
+			renderThread = false;
+		}
+	}
+
 	Game game;
-	bool success = game.Initialize();
+	bool success = game.Initialize(headless, compactGBuffer, renderThread);
 	if (success)
 	{
-		game.RunLoop();
+		game.RunLoop(numFrames);
+		if (profileFile)
+		{
+			Profiler::DumpChromeTrace(profileFile, Profiler::MaxFrames);
+		}
 	}
 	game.Shutdown();
 	return 0;
@@ -723,6 +723,18 @@ public:
 		return retVal;
 	}
 
+	// Largest scale along any axis (scales a bounding sphere's radius)
+	float GetMaxScale() const
+	{
+		float maxSq = 0.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			Vector3 axis(mat[i][0], mat[i][1], mat[i][2]);
+			maxSq = Math::Max(maxSq, axis.LengthSq());
+		}
+		return Math::Sqrt(maxSq);
+	}
+
 	// Create a scale matrix with x, y, and z scales
 	static Matrix4 CreateScale(float xScale, float yScale, float zScale)
 	{
@@ -14,7 +14,10 @@
 #include <SDL/SDL_log.h>
 #include "Math.h"
 #include "LevelLoader.h"
+#include "MeshSimplifier.h"
 #include <fstream>
+#include <cstring>
+#include <cmath>
 
 namespace
 {
@@ -24,7 +27,7 @@ namespace
 		uint8_t b[4];
 	};
 
-	const int BinaryVersion = 1;
+	const int BinaryVersion = 3;
 	struct MeshBinHeader
 	{
 		// Signature for file type
@@ -37,11 +40,93 @@ namespace
 		uint32_t mNumTextures = 0;
 		uint32_t mNumVerts = 0;
 		uint32_t mNumIndices = 0;
+		uint32_t mNumLods = 0;
 		// Box/radius of mesh, used for collision
 		AABB mBox{ Vector3::Zero, Vector3::Zero };
 		float mRadius = 0.0f;
 		float mSpecPower = 100.0f;
 	};
+
+	// Most LODs a mesh has (including full detail)
+	const size_t MaxLods = 4;
+	// Each LOD aims for this fraction of the previous one's triangles
+	const float LodReduction = 0.5f;
+	// An LOD that keeps more than this fraction isn't worth having
+	const float MinLodReduction = 0.8f;
+	// LOD 1 is used once the bounding sphere is smaller than this on
+	// screen, and each LOD after at half the size of the one before
+	const float FirstLodScreenSize = 0.4f;
+	// How far past a threshold the size has to go to switch LOD
+	const float LodHysteresis = 0.15f;
+
+	float LodThreshold(size_t lod)
+	{
+		return FirstLodScreenSize / static_cast<float>(1 << (lod - 1));
+	}
+
+	// Largest step between packed positions (in object space) before
+	// a mesh is left with float positions
+	const float MaxPackedPositionStep = 0.05f;
+
+	// Nearest half float to f
+	uint16_t ToHalf(float f)
+	{
+		uint32_t bits = 0;
+		std::memcpy(&bits, &f, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000;
+		int exponent = static_cast<int>((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffff;
+		if (exponent >= 31)
+		{
+			// Too large, so infinity
+			return static_cast<uint16_t>(sign | 0x7c00);
+		}
+		if (exponent <= 0)
+		{
+			// Too small for anything but a denormal (or zero)
+			if (exponent < -10)
+			{
+				return static_cast<uint16_t>(sign);
+			}
+			mantissa |= 0x800000;
+			int shift = 14 - exponent;
+			uint32_t half = mantissa >> shift;
+			if ((mantissa >> (shift - 1)) & 1)
+			{
+				half++;
+			}
+			return static_cast<uint16_t>(sign | half);
+		}
+		uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+		// Round to nearest (which can carry into the exponent)
+		if (mantissa & 0x1000)
+		{
+			half++;
+		}
+		return static_cast<uint16_t>(half);
+	}
+
+	// Signed normalized 10:10:10:2, with w left as 0
+	uint32_t PackNormal(const float* normal)
+	{
+		uint32_t packed = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			float n = Math::Clamp(normal[i], -1.0f, 1.0f);
+			int c = static_cast<int>(std::floor(n * 511.0f + 0.5f));
+			packed |= (static_cast<uint32_t>(c) & 0x3ff) << (i * 10);
+		}
+		return packed;
+	}
+}
+
+Mesh::Data::Data()
+	:mLayout(VertexArray::PosNormTex)
+	,mNumVerts(0)
+	,mBox(Vector3::Infinity, Vector3::NegInfinity)
+	,mRadius(0.0f)
+	,mSpecPower(100.0f)
+{
 }
 
 Mesh::Mesh()
@@ -58,10 +143,19 @@ Mesh::~Mesh()
 
 bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 {
-	mFileName = fileName;
+	Data data;
+	if (!LoadData(fileName, data))
+	{
+		return false;
+	}
+	Create(fileName, data, renderer);
+	return true;
+}
 
+bool Mesh::LoadData(const std::string& fileName, Data& outData)
+{
 	// Try loading the binary file first
-	if (LoadBinary(fileName + ".bin", renderer))
+	if (LoadBinary(fileName + ".bin", outData))
 	{
 		return true;
 	}
@@ -82,7 +176,7 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 		return false;
 	}
 
-	mShaderName = doc["shader"].GetString();
+	outData.mShaderName = doc["shader"].GetString();
 
 	// Set the vertex layout/size based on the format in the file
 	VertexArray::Layout layout = VertexArray::PosNormTex;
@@ -95,8 +189,9 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 		// This is the number of "Vertex" unions, which is 8 + 2 (for skinning)s
 		vertSize = 10;
 	}
+	outData.mLayout = layout;
 
-	// Load textures
+	// Load texture names
 	const rapidjson::Value& textures = doc["textures"];
 	if (!textures.IsArray() || textures.Size() < 1)
 	{
@@ -104,21 +199,11 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 		return false;
 	}
 
-	mSpecPower = static_cast<float>(doc["specularPower"].GetDouble());
+	outData.mSpecPower = static_cast<float>(doc["specularPower"].GetDouble());
 
-	std::vector<std::string> textureNames;
 	for (rapidjson::SizeType i = 0; i < textures.Size(); i++)
 	{
-		// Is this texture already loaded?
-		std::string texName = textures[i].GetString();
-		textureNames.emplace_back(texName);
-		Texture* t = renderer->GetTexture(texName);
-		if (t == nullptr)
-		{
-			// If it's null, use the default texture
-			t = renderer->GetTexture("Assets/Default.png");
-		}
-		mTextures.emplace_back(t);
+		outData.mTextureNames.emplace_back(textures[i].GetString());
 	}
 
 	// Load in the vertices
@@ -131,7 +216,7 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 
 	std::vector<Vertex> vertices;
 	vertices.reserve(vertsJson.Size() * vertSize);
-	mRadius = 0.0f;
+	float radius = 0.0f;
 	for (rapidjson::SizeType i = 0; i < vertsJson.Size(); i++)
 	{
 		// For now, just assume we have 8 elements
@@ -143,8 +228,8 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 		}
 
 		Vector3 pos(vert[0].GetDouble(), vert[1].GetDouble(), vert[2].GetDouble());
-		mRadius = Math::Max(mRadius, pos.LengthSq());
-		mBox.UpdateMinMax(pos);
+		radius = Math::Max(radius, pos.LengthSq());
+		outData.mBox.UpdateMinMax(pos);
 
 		if (layout == VertexArray::PosNormTex)
 		{
@@ -186,7 +271,7 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 	}
 
 	// We were computing length squared earlier
-	mRadius = Math::Sqrt(mRadius);
+	outData.mRadius = Math::Sqrt(radius);
 
 	// Load in the indices
 	const rapidjson::Value& indJson = doc["indices"];
@@ -196,8 +281,7 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 		return false;
 	}
 
-	std::vector<unsigned int> indices;
-	indices.reserve(indJson.Size() * 3);
+	outData.mIndices.reserve(indJson.Size() * 3);
 	for (rapidjson::SizeType i = 0; i < indJson.Size(); i++)
 	{
 		const rapidjson::Value& ind = indJson[i];
@@ -207,31 +291,129 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 			return false;
 		}
 
-		indices.emplace_back(ind[0].GetUint());
-		indices.emplace_back(ind[1].GetUint());
-		indices.emplace_back(ind[2].GetUint());
+		outData.mIndices.emplace_back(ind[0].GetUint());
+		outData.mIndices.emplace_back(ind[1].GetUint());
+		outData.mIndices.emplace_back(ind[2].GetUint());
 	}
 
-	// Now create a vertex array
-	unsigned int numVerts = static_cast<unsigned>(vertices.size()) / vertSize;
-	mVertexArray = new VertexArray(vertices.data(), numVerts,
-		layout, indices.data(), static_cast<unsigned>(indices.size()));
+	outData.mNumVerts = static_cast<unsigned>(vertices.size() / vertSize);
+	const char* vertBytes = reinterpret_cast<const char*>(vertices.data());
+	outData.mVerts.assign(vertBytes, vertBytes + vertices.size() * sizeof(Vertex));
+
+	BuildLods(outData);
+	// (Simplifying needs the float positions, so pack after)
+	PackVertices(outData);
 
 	// Save the binary mesh
-	SaveBinary(fileName + ".bin", vertices.data(),
-		numVerts, layout, indices.data(),
-		static_cast<unsigned>(indices.size()),
-		textureNames, mBox, mRadius,
-		mSpecPower);
+	SaveBinary(fileName + ".bin", outData);
 	return true;
 }
 
+void Mesh::Create(const std::string& fileName, const Data& data,
+	Renderer* renderer, bool asyncTextures)
+{
+	mFileName = fileName;
+	mShaderName = data.mShaderName;
+	mBox = data.mBox;
+	mRadius = data.mRadius;
+	mSpecPower = data.mSpecPower;
+	mLods = data.mLods;
+	if (mLods.empty())
+	{
+		Lod lod;
+		lod.mFirstIndex = 0;
+		lod.mNumIndices = static_cast<uint32_t>(data.mIndices.size());
+		mLods.emplace_back(lod);
+	}
+
+	for (const std::string& texName : data.mTextureNames)
+	{
+		// Is this texture already loaded?
+		Texture* t = renderer->GetTexture(texName, asyncTextures);
+		if (t == nullptr)
+		{
+			// If it's null, use the default texture
+			t = renderer->GetTexture("Assets/Default.png");
+		}
+		mTextures.emplace_back(t);
+	}
+
+	// Now create a vertex array (unless there's no GL context)
+	if (!renderer->IsHeadless())
+	{
+		mVertexArray = new VertexArray(data.mVerts.data(), data.mNumVerts,
+			data.mLayout, data.mIndices.data(),
+			static_cast<unsigned>(data.mIndices.size()));
+		// Packed positions are relative to the bounding box
+		if (VertexArray::IsPacked(data.mLayout))
+		{
+			mVertexArray->SetPositionDecode(mBox.mMax - mBox.mMin, mBox.mMin);
+		}
+	}
+}
+
 void Mesh::Unload()
 {
 	delete mVertexArray;
 	mVertexArray = nullptr;
 }
 
+size_t Mesh::SelectLod(float screenSize, size_t current) const
+{
+	if (mLods.empty())
+	{
+		return 0;
+	}
+	size_t lod = Math::Min(current, mLods.size() - 1);
+	// Coarser while it's well under the next LOD's threshold
+	while (lod + 1 < mLods.size() &&
+		screenSize < LodThreshold(lod + 1) * (1.0f - LodHysteresis))
+	{
+		lod++;
+	}
+	// Finer while it's well over this LOD's threshold
+	while (lod > 0 && screenSize > LodThreshold(lod) * (1.0f + LodHysteresis))
+	{
+		lod--;
+	}
+	return lod;
+}
+
+void Mesh::BuildLods(Data& data)
+{
+	data.mLods.clear();
+	Lod full;
+	full.mFirstIndex = 0;
+	full.mNumIndices = static_cast<uint32_t>(data.mIndices.size());
+	data.mLods.emplace_back(full);
+
+	// Positions are the first three floats of each vertex
+	const float* positions = reinterpret_cast<const float*>(data.mVerts.data());
+	size_t stride = VertexArray::GetVertexSize(data.mLayout) / sizeof(float);
+
+	// Each LOD is simplified from the one before
+	std::vector<uint32_t> source(data.mIndices);
+	std::vector<uint32_t> simplified;
+	while (data.mLods.size() < MaxLods)
+	{
+		size_t target = static_cast<size_t>(source.size() * LodReduction) / 3 * 3;
+		MeshSimplifier::Simplify(positions, stride, data.mNumVerts, source,
+			target, simplified);
+		// Stop once it can't get much simpler (seams and borders don't move)
+		if (simplified.empty() || simplified.size() > source.size() * MinLodReduction)
+		{
+			break;
+		}
+
+		Lod lod;
+		lod.mFirstIndex = static_cast<uint32_t>(data.mIndices.size());
+		lod.mNumIndices = static_cast<uint32_t>(simplified.size());
+		data.mIndices.insert(data.mIndices.end(), simplified.begin(), simplified.end());
+		data.mLods.emplace_back(lod);
+		source.swap(simplified);
+	}
+}
+
 Texture* Mesh::GetTexture(size_t index)
 {
 	if (index < mTextures.size())
@@ -244,22 +426,77 @@ Texture* Mesh::GetTexture(size_t index)
 	}
 }
 
-void Mesh::SaveBinary(const std::string& fileName, const void* verts, 
-	uint32_t numVerts, VertexArray::Layout layout,
-	const uint32_t* indices, uint32_t numIndices,
-	const std::vector<std::string>& textureNames,
-	const AABB& box, float radius,
-	float specPower)
+void Mesh::PackVertices(Data& data)
+{
+	Vector3 extent = data.mBox.mMax - data.mBox.mMin;
+	float largest = Math::Max(extent.x, Math::Max(extent.y, extent.z));
+	if (VertexArray::IsPacked(data.mLayout) ||
+		largest / 65535.0f > MaxPackedPositionStep)
+	{
+		return;
+	}
+
+	bool skinned = data.mLayout == VertexArray::PosNormSkinTex;
+	VertexArray::Layout packedLayout = skinned ?
+		VertexArray::PosNormSkinTexPacked : VertexArray::PosNormTexPacked;
+	unsigned srcSize = VertexArray::GetVertexSize(data.mLayout);
+	unsigned dstSize = VertexArray::GetVertexSize(packedLayout);
+	const float* boxMin = data.mBox.mMin.GetAsFloatPtr();
+	const float* boxSize = extent.GetAsFloatPtr();
+
+	std::vector<char> packed(data.mNumVerts * dstSize);
+	for (uint32_t i = 0; i < data.mNumVerts; i++)
+	{
+		const char* src = &data.mVerts[i * srcSize];
+		char* dst = &packed[i * dstSize];
+		float floats[6];
+		std::memcpy(floats, src, sizeof(floats));
+		src += sizeof(floats);
+
+		// Position is 0-1 within the box (with a short of padding)
+		uint16_t pos[4] = { 0, 0, 0, 0 };
+		for (int c = 0; c < 3; c++)
+		{
+			float t = boxSize[c] > 0.0f ? (floats[c] - boxMin[c]) / boxSize[c] : 0.0f;
+			pos[c] = static_cast<uint16_t>(Math::Clamp(t, 0.0f, 1.0f) * 65535.0f + 0.5f);
+		}
+		std::memcpy(dst, pos, sizeof(pos));
+		dst += sizeof(pos);
+
+		uint32_t normal = PackNormal(floats + 3);
+		std::memcpy(dst, &normal, sizeof(normal));
+		dst += sizeof(normal);
+
+		// Skinning bones/weights are already bytes
+		if (skinned)
+		{
+			std::memcpy(dst, src, 8);
+			src += 8;
+			dst += 8;
+		}
+
+		float uv[2];
+		std::memcpy(uv, src, sizeof(uv));
+		uint16_t texCoord[2] = { ToHalf(uv[0]), ToHalf(uv[1]) };
+		std::memcpy(dst, texCoord, sizeof(texCoord));
+	}
+	data.mVerts.swap(packed);
+	data.mLayout = packedLayout;
+}
+
+void Mesh::SaveBinary(const std::string& fileName, const Data& data)
 {
 	// Create header struct
 	MeshBinHeader header;
-	header.mLayout = layout;
+	header.mLayout = data.mLayout;
 	header.mNumTextures = 
-		static_cast<unsigned>(textureNames.size());
-	header.mNumVerts = numVerts;
-	header.mNumIndices = numIndices;
-	header.mBox = box;
-	header.mRadius = radius;
+		static_cast<unsigned>(data.mTextureNames.size());
+	header.mNumVerts = data.mNumVerts;
+	header.mNumIndices = static_cast<unsigned>(data.mIndices.size());
+	header.mNumLods = static_cast<unsigned>(data.mLods.size());
+	header.mBox = data.mBox;
+	header.mRadius = data.mRadius;
+	header.mSpecPower = data.mSpecPower;
 
 	// Open binary file for writing
 	std::ofstream outFile(fileName, std::ios::out 
@@ -271,7 +508,7 @@ void Mesh::SaveBinary(const std::string& fileName, const void* verts,
 
 		// For each texture, we need to write the size of the name
 		// followed by the string (null-terminated)
-		for (const auto& tex : textureNames)
+		for (const auto& tex : data.mTextureNames)
 		{
 			// (Assume file names won't have more than 32k characters)
 			uint16_t nameSize = static_cast<uint16_t>(tex.length()) + 1;
@@ -280,18 +517,18 @@ void Mesh::SaveBinary(const std::string& fileName, const void* verts,
 			outFile.write("\0", 1);
 		}
 
-		// Figure out number of bytes for each vertex, based on layout
-		unsigned vertexSize = VertexArray::GetVertexSize(layout);
 		// Write vertices
-		outFile.write(reinterpret_cast<const char*>(verts), 
-			numVerts * vertexSize);
+		outFile.write(data.mVerts.data(), data.mVerts.size());
 		// Write indices
-		outFile.write(reinterpret_cast<const char*>(indices), 
-			numIndices * sizeof(uint32_t));
+		outFile.write(reinterpret_cast<const char*>(data.mIndices.data()), 
+			data.mIndices.size() * sizeof(uint32_t));
+		// Write LOD index ranges
+		outFile.write(reinterpret_cast<const char*>(data.mLods.data()),
+			data.mLods.size() * sizeof(Lod));
 	}
 }
 
-bool Mesh::LoadBinary(const std::string& fileName, Renderer* renderer)
+bool Mesh::LoadBinary(const std::string& fileName, Data& outData)
 {
 	std::ifstream inFile(fileName, std::ios::in | 
 		std::ios::binary);
@@ -320,41 +557,31 @@ bool Mesh::LoadBinary(const std::string& fileName, Renderer* renderer)
 			char* texName = new char[nameSize];
 			// Read in the texture name
 			inFile.read(texName, nameSize);
-			
-			// Get this texture
-			Texture* t = renderer->GetTexture(texName);
-			if (t == nullptr)
-			{
-				// If it's null, use the default texture
-				t = renderer->GetTexture("Assets/Default.png");
-			}
-			mTextures.emplace_back(t);
-
+			outData.mTextureNames.emplace_back(texName);
 			delete[] texName;
 		}
 
 		// Now read in the vertices
 		unsigned vertexSize = VertexArray::GetVertexSize(header.mLayout);
-		char* verts = new char[header.mNumVerts * vertexSize];
-		inFile.read(verts, header.mNumVerts * vertexSize);
+		outData.mVerts.resize(header.mNumVerts * vertexSize);
+		inFile.read(outData.mVerts.data(), outData.mVerts.size());
 
 		// Now read in the indices
-		uint32_t* indices = new uint32_t[header.mNumIndices];
-		inFile.read(reinterpret_cast<char*>(indices), 
+		outData.mIndices.resize(header.mNumIndices);
+		inFile.read(reinterpret_cast<char*>(outData.mIndices.data()), 
 			header.mNumIndices * sizeof(uint32_t));
 
-		// Now create the vertex array
-		mVertexArray = new VertexArray(verts, header.mNumVerts,
-			header.mLayout, indices, header.mNumIndices);
-
-		// Cleanup memory
-		delete[] verts;
-		delete[] indices;
-
-		// Set mBox/mRadius/specular from header
-		mBox = header.mBox;
-		mRadius = header.mRadius;
-		mSpecPower = header.mSpecPower;
+		// And the LOD index ranges
+		outData.mLods.resize(header.mNumLods);
+		inFile.read(reinterpret_cast<char*>(outData.mLods.data()),
+			header.mNumLods * sizeof(Lod));
+
+		// Set layout/counts/mBox/mRadius/specular from header
+		outData.mLayout = header.mLayout;
+		outData.mNumVerts = header.mNumVerts;
+		outData.mBox = header.mBox;
+		outData.mRadius = header.mRadius;
+		outData.mSpecPower = header.mSpecPower;
 
 		return true;
 	}
@@ -15,35 +15,79 @@
 class Mesh
 {
 public:
+	// A level of detail is a range of the index buffer
+	// (every LOD shares the vertices)
+	struct Lod
+	{
+		uint32_t mFirstIndex;
+		uint32_t mNumIndices;
+	};
+
+	// Everything read from a mesh file, before any GL objects are made
+	// (so it can be loaded on any thread)
+	struct Data
+	{
+		Data();
+		VertexArray::Layout mLayout;
+		std::vector<char> mVerts;
+		uint32_t mNumVerts;
+		std::vector<uint32_t> mIndices;
+		// Full detail first
+		std::vector<Lod> mLods;
+		std::vector<std::string> mTextureNames;
+		std::string mShaderName;
+		AABB mBox;
+		float mRadius;
+		float mSpecPower;
+	};
+
 	Mesh();
 	~Mesh();
 	// Load/unload mesh
 	bool Load(const std::string& fileName, class Renderer* renderer);
 	void Unload();
+	// Read the file into data (binary file first)
+	static bool LoadData(const std::string& fileName, Data& outData);
+	// Make the vertex array and get the textures for loaded data
+	// (if asyncTextures, they're loaded in the background)
+	void Create(const std::string& fileName, const Data& data,
+		class Renderer* renderer, bool asyncTextures = false);
 	// Get the vertex array associated with this mesh
 	VertexArray* GetVertexArray() { return mVertexArray; }
+	// False while the mesh is still loading in the background
+	// (and always in headless mode, where there's no vertex array)
+	bool IsLoaded() const { return mVertexArray != nullptr; }
 	// Get a texture from specified index
 	class Texture* GetTexture(size_t index);
 	// Get name of shader
 	const std::string& GetShaderName() const { return mShaderName; }
 	// Get file name
 	const std::string& GetFileName() const { return mFileName; }
+	void SetFileName(const std::string& fileName) { mFileName = fileName; }
 	// Get object space bounding sphere radius
 	float GetRadius() const { return mRadius; }
 	// Get object space bounding box
 	const AABB& GetBox() const { return mBox; }
 	// Get specular power of mesh
 	float GetSpecPower() const { return mSpecPower; }
+	size_t GetNumLods() const { return mLods.size(); }
+	const Lod& GetLod(size_t index) const { return mLods[index]; }
+	// Pick the LOD for a bounding sphere this size on screen (its
+	// projected radius, where 1 is half the screen height). current
+	// is the LOD used last frame, which is kept until the size moves
+	// past its threshold by a margin, so LODs don't flicker
+	size_t SelectLod(float screenSize, size_t current) const;
 
 	// Save the mesh in binary format
-	void SaveBinary(const std::string& fileName, const void* verts, 
-		uint32_t numVerts, VertexArray::Layout layout,
-		const uint32_t* indices, uint32_t numIndices,
-		const std::vector<std::string>& textureNames,
-		const AABB& box, float radius,
-		float specPower);
+	static void SaveBinary(const std::string& fileName, const Data& data);
 	// Load in the mesh from binary format
-	bool LoadBinary(const std::string& fileName, class Renderer* renderer);
+	static bool LoadBinary(const std::string& fileName, Data& outData);
+	// Simplify the full detail indices into more LODs
+	// (appended to the indices)
+	static void BuildLods(Data& data);
+	// Convert float vertices to the matching packed layout, unless the
+	// mesh is too large for 16-bit positions to be accurate enough
+	static void PackVertices(Data& data);
 private:
 	// AABB collision
 	AABB mBox;
@@ -51,6 +95,7 @@ private:
 	std::vector<class Texture*> mTextures;
 	// Vertex array associated with this mesh
 	VertexArray* mVertexArray;
+	std::vector<Lod> mLods;
 	// Name of shader specified by mesh
 	std::string mShaderName;
 	// Name of mesh file
@@ -15,11 +15,13 @@
 #include "Texture.h"
 #include "VertexArray.h"
 #include "LevelLoader.h"
+#include "RenderPacket.h"
 
 MeshComponent::MeshComponent(Actor* owner, bool isSkeletal)
 	:Component(owner)
 	,mMesh(nullptr)
 	,mTextureIndex(0)
+	,mLod(0)
 	,mVisible(true)
 	,mIsSkeletal(isSkeletal)
 {
@@ -31,27 +33,54 @@ MeshComponent::~MeshComponent()
 	mOwner->GetGame()->GetRenderer()->RemoveMeshComp(this);
 }
 
-void MeshComponent::Draw(Shader* shader)
+void MeshComponent::OnRecycle()
+{
+	Component::OnRecycle();
+	mOwner->GetGame()->GetRenderer()->RemoveMeshComp(this);
+}
+
+void MeshComponent::OnReuse()
+{
+	Component::OnReuse();
+	mOwner->GetGame()->GetRenderer()->AddMeshComp(this);
+}
+
+void MeshComponent::QueueDraw(RenderPacket* packet, Shader* shader, const Matrix4& view)
 {
 	if (mMesh)
 	{
-		// Set the world transform
-		shader->SetMatrixUniform("uWorldTransform", 
-			mOwner->GetWorldTransform());
-		// Set specular power
-		shader->SetFloatUniform("uSpecPower", mMesh->GetSpecPower());
-		// Set the active texture
-		Texture* t = mMesh->GetTexture(mTextureIndex);
-		if (t)
-		{
-			t->SetActive();
-		}
-		// Set the mesh's vertex array as active
-		VertexArray* va = mMesh->GetVertexArray();
-		va->SetActive();
-		// Draw
-		glDrawElements(GL_TRIANGLES, va->GetNumIndices(), GL_UNSIGNED_INT, nullptr);
+		RenderQueue::DrawItem item;
+		item.mShader = shader;
+		item.mVertexArray = mMesh->GetVertexArray();
+		Texture* texture = mMesh->GetTexture(mTextureIndex);
+		item.mTextureID = texture ? texture->GetTextureID() : 0;
+		item.mWorldTransform = nullptr;
+		item.mPalette = nullptr;
+		item.mPaletteSize = 0;
+		item.mSpecPower = mMesh->GetSpecPower();
+		Vector3 viewPos = Vector3::Transform(
+			mOwner->GetRenderTransform().GetTranslation(), view);
+		UpdateLod(viewPos.z, packet->mProjection);
+		const Mesh::Lod& lod = mMesh->GetLod(mLod);
+		item.mFirstIndex = lod.mFirstIndex;
+		item.mNumIndices = lod.mNumIndices;
+		packet->AddMesh(item, viewPos.z, mOwner->GetRenderTransform());
+	}
+}
+
+void MeshComponent::UpdateLod(float depth, const Matrix4& proj)
+{
+	// Up close (or at the camera), always use full detail
+	if (depth <= 0.0f)
+	{
+		mLod = 0;
+		return;
 	}
+	// Radius in NDC, where the screen is 2 high
+	// (scaled the same way culling does, so it includes parents' scale)
+	float radius = mMesh->GetRadius() * mOwner->GetRenderTransform().GetMaxScale();
+	float screenSize = radius * proj.mat[1][1] / depth;
+	mLod = mMesh->SelectLod(screenSize, mLod);
 }
 
 void MeshComponent::LoadProperties(const rapidjson::Value& inObj)
@@ -61,7 +90,8 @@ void MeshComponent::LoadProperties(const rapidjson::Value& inObj)
 	std::string meshFile;
 	if (JsonHelper::GetString(inObj, "meshFile", meshFile))
 	{
-		SetMesh(mOwner->GetGame()->GetRenderer()->GetMesh(meshFile));
+		// (Streams in, so loading a level doesn't stall on every mesh)
+		SetMesh(mOwner->GetGame()->GetRenderer()->GetMesh(meshFile, true));
 	}
 
 	int idx;
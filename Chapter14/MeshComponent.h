@@ -14,11 +14,18 @@ class MeshComponent : public Component
 public:
 	MeshComponent(class Actor* owner, bool isSkeletal = false);
 	~MeshComponent();
-	// Draw this mesh component
-	virtual void Draw(class Shader* shader);
+
+	void OnRecycle() override;
+	void OnReuse() override;
+
+	// Add a draw of this mesh component to the frame's packet
+	// (view is used to find how far away it is, and so which LOD)
+	virtual void QueueDraw(struct RenderPacket* packet, class Shader* shader,
+		const Matrix4& view);
 	// Set the mesh/texture index used by mesh component
-	virtual void SetMesh(class Mesh* mesh) { mMesh = mesh; }
+	virtual void SetMesh(class Mesh* mesh) { mMesh = mesh; mLod = 0; }
 	void SetTextureIndex(size_t index) { mTextureIndex = index; }
+	class Mesh* GetMesh() const { return mMesh; }
 
 	void SetVisible(bool visible) { mVisible = visible; }
 	bool GetVisible() const { return mVisible; }
@@ -31,8 +38,14 @@ public:
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
 protected:
+	// Pick this frame's LOD from how large the mesh's bounding sphere
+	// is on screen, at this view space depth
+	void UpdateLod(float depth, const Matrix4& proj);
+
 	class Mesh* mMesh;
 	size_t mTextureIndex;
+	// LOD drawn last frame
+	size_t mLod;
 	bool mVisible;
 	bool mIsSkeletal;
 };
\ No newline at end of file
@@ -0,0 +1,407 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "MeshSimplifier.h"
+#include "Math.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+	// Most passes over the mesh (each pass does many collapses)
+	const int MaxPasses = 64;
+	// Planes along open edges count this much more than triangles,
+	// so the outline doesn't shrink
+	const float BorderWeight = 10.0f;
+	// A collapse can't turn a triangle further than this (cosine)
+	const float MinNormalDot = 0.25f;
+
+	enum VertexKind
+	{
+		// Can collapse along any edge
+		EManifold,
+		// On an open edge, so can only collapse along open edges
+		EBorder,
+		// On a seam or a non-manifold edge, so can't move
+		ELocked
+	};
+
+	// Symmetric 4x4 matrix Q, where v^T Q v is the sum of squared
+	// distances from v to a set of planes (only 10 unique entries)
+	struct Quadric
+	{
+		double mQ[10];
+	};
+
+	// Quadric for the plane dot(normal, v) + d = 0
+	Quadric MakeQuadric(const Vector3& normal, float d, float weight)
+	{
+		double a = normal.x;
+		double b = normal.y;
+		double c = normal.z;
+		Quadric q;
+		q.mQ[0] = a * a * weight;
+		q.mQ[1] = a * b * weight;
+		q.mQ[2] = a * c * weight;
+		q.mQ[3] = a * d * weight;
+		q.mQ[4] = b * b * weight;
+		q.mQ[5] = b * c * weight;
+		q.mQ[6] = b * d * weight;
+		q.mQ[7] = c * c * weight;
+		q.mQ[8] = c * d * weight;
+		q.mQ[9] = static_cast<double>(d) * d * weight;
+		return q;
+	}
+
+	void AddQuadric(Quadric& q, const Quadric& other)
+	{
+		for (int i = 0; i < 10; i++)
+		{
+			q.mQ[i] += other.mQ[i];
+		}
+	}
+
+	double Evaluate(const Quadric& q, const Vector3& v)
+	{
+		double x = v.x;
+		double y = v.y;
+		double z = v.z;
+		const double* m = q.mQ;
+		return m[0] * x * x + m[4] * y * y + m[7] * z * z +
+			2.0 * (m[1] * x * y + m[2] * x * z + m[5] * y * z) +
+			2.0 * (m[3] * x + m[6] * y + m[8] * z) + m[9];
+	}
+
+	// Collapse vertex mFrom onto vertex mTo
+	struct Collapse
+	{
+		uint32_t mFrom;
+		uint32_t mTo;
+		double mCost;
+	};
+
+	uint64_t EdgeKey(uint32_t a, uint32_t b)
+	{
+		if (a > b)
+		{
+			std::swap(a, b);
+		}
+		return (static_cast<uint64_t>(a) << 32) | b;
+	}
+}
+
+float MeshSimplifier::Simplify(const float* positions, size_t stride, size_t numVerts,
+	const std::vector<uint32_t>& indices, size_t targetIndexCount,
+	std::vector<uint32_t>& outIndices)
+{
+	auto pos = [positions, stride](uint32_t v) {
+		const float* p = positions + v * stride;
+		return Vector3(p[0], p[1], p[2]);
+	};
+
+	// Vertices at the same position (split by their normals/UVs) are
+	// treated as one, so map each to the first used one at its position
+	std::vector<uint32_t> remap(numVerts);
+	std::vector<uint8_t> used(numVerts, 0);
+	for (uint32_t v : indices)
+	{
+		used[v] = 1;
+	}
+	std::vector<uint32_t> order;
+	for (uint32_t v = 0; v < numVerts; v++)
+	{
+		remap[v] = v;
+		if (used[v])
+		{
+			order.emplace_back(v);
+		}
+	}
+	std::sort(order.begin(), order.end(), [&pos](uint32_t a, uint32_t b) {
+		Vector3 pa = pos(a);
+		Vector3 pb = pos(b);
+		if (pa.x != pb.x)
+		{
+			return pa.x < pb.x;
+		}
+		if (pa.y != pb.y)
+		{
+			return pa.y < pb.y;
+		}
+		if (pa.z != pb.z)
+		{
+			return pa.z < pb.z;
+		}
+		return a < b;
+	});
+	std::vector<uint8_t> split(numVerts, 0);
+	for (size_t i = 1; i < order.size(); i++)
+	{
+		Vector3 pa = pos(order[i - 1]);
+		Vector3 pb = pos(order[i]);
+		if (pa.x == pb.x && pa.y == pb.y && pa.z == pb.z)
+		{
+			remap[order[i]] = remap[order[i - 1]];
+			split[remap[order[i]]] = 1;
+		}
+	}
+
+	// Each position's quadric starts with the planes of its triangles
+	// (weighted by area)
+	std::vector<Quadric> quadrics(numVerts, Quadric());
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		Vector3 p0 = pos(indices[i]);
+		Vector3 normal = Vector3::Cross(pos(indices[i + 1]) - p0, pos(indices[i + 2]) - p0);
+		float length = normal.Length();
+		if (length <= 0.0f)
+		{
+			continue;
+		}
+		normal.Normalize();
+		Quadric q = MakeQuadric(normal, -Vector3::Dot(normal, p0), length * 0.5f);
+		for (int c = 0; c < 3; c++)
+		{
+			AddQuadric(quadrics[remap[indices[i + c]]], q);
+		}
+	}
+
+	std::vector<uint32_t> tris(indices);
+	// What each vertex collapsed onto (or itself)
+	std::vector<uint32_t> collapsed(numVerts);
+	for (uint32_t v = 0; v < numVerts; v++)
+	{
+		collapsed[v] = v;
+	}
+	double maxCost = 0.0;
+
+	std::unordered_map<uint64_t, int> edgeCounts;
+	std::vector<uint8_t> kinds(numVerts);
+	std::vector<uint8_t> borderEdges(numVerts);
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> adjOffsets;
+	std::vector<uint32_t> adjTris;
+	std::vector<uint8_t> touched(numVerts);
+	for (int pass = 0; pass < MaxPasses && tris.size() > targetIndexCount; pass++)
+	{
+		// Count the triangles on each edge (between positions)
+		edgeCounts.clear();
+		for (size_t i = 0; i < tris.size(); i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				edgeCounts[EdgeKey(remap[tris[i + e]], remap[tris[i + (e + 1) % 3]])]++;
+			}
+		}
+
+		// Classify positions by their edges
+		for (size_t v = 0; v < numVerts; v++)
+		{
+			kinds[v] = split[v] ? ELocked : EManifold;
+			borderEdges[v] = 0;
+		}
+		for (const auto& edge : edgeCounts)
+		{
+			uint32_t ends[2] = { static_cast<uint32_t>(edge.first >> 32),
+				static_cast<uint32_t>(edge.first) };
+			for (uint32_t v : ends)
+			{
+				if (edge.second > 2)
+				{
+					kinds[v] = ELocked;
+				}
+				else if (edge.second == 1)
+				{
+					borderEdges[v]++;
+					if (kinds[v] == EManifold)
+					{
+						kinds[v] = EBorder;
+					}
+				}
+			}
+		}
+		for (size_t v = 0; v < numVerts; v++)
+		{
+			// (Where open edges meet more than two at a time)
+			if (borderEdges[v] > 2)
+			{
+				kinds[v] = ELocked;
+			}
+		}
+
+		// Open edges also get a plane through them, perpendicular to
+		// their triangle, to hold them in place
+		if (pass == 0)
+		{
+			for (size_t i = 0; i < tris.size(); i += 3)
+			{
+				Vector3 p0 = pos(tris[i]);
+				Vector3 normal = Vector3::Cross(pos(tris[i + 1]) - p0, pos(tris[i + 2]) - p0);
+				if (normal.LengthSq() <= 0.0f)
+				{
+					continue;
+				}
+				normal.Normalize();
+				for (int e = 0; e < 3; e++)
+				{
+					uint32_t a = remap[tris[i + e]];
+					uint32_t b = remap[tris[i + (e + 1) % 3]];
+					if (edgeCounts[EdgeKey(a, b)] != 1)
+					{
+						continue;
+					}
+					Vector3 edgeDir = pos(b) - pos(a);
+					float length = edgeDir.Length();
+					Vector3 planeNormal = Vector3::Cross(edgeDir, normal);
+					if (planeNormal.LengthSq() <= 0.0f)
+					{
+						continue;
+					}
+					planeNormal.Normalize();
+					Quadric q = MakeQuadric(planeNormal, -Vector3::Dot(planeNormal, pos(a)),
+						length * length * BorderWeight);
+					AddQuadric(quadrics[a], q);
+					AddQuadric(quadrics[b], q);
+				}
+			}
+		}
+
+		// Every collapse that keeps borders/seams, by cost
+		collapses.clear();
+		for (size_t i = 0; i < tris.size(); i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				uint32_t a = tris[i + e];
+				uint32_t b = tris[i + (e + 1) % 3];
+				uint32_t ends[2][2] = { { a, b }, { b, a } };
+				for (auto& end : ends)
+				{
+					uint32_t from = remap[end[0]];
+					uint32_t to = remap[end[1]];
+					if (kinds[from] == ELocked ||
+						(kinds[from] == EBorder && edgeCounts[EdgeKey(from, to)] != 1))
+					{
+						continue;
+					}
+					// (An unlocked position only has one vertex, so from
+					// is the vertex itself)
+					Collapse collapse;
+					collapse.mFrom = from;
+					collapse.mTo = end[1];
+					collapse.mCost = Evaluate(quadrics[from], pos(end[1]));
+					collapses.emplace_back(collapse);
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(),
+			[](const Collapse& a, const Collapse& b) {
+				return a.mCost < b.mCost;
+		});
+
+		// Triangles around each position, to check for flips
+		adjOffsets.assign(numVerts + 1, 0);
+		for (uint32_t v : tris)
+		{
+			adjOffsets[remap[v] + 1]++;
+		}
+		for (size_t v = 0; v < numVerts; v++)
+		{
+			adjOffsets[v + 1] += adjOffsets[v];
+		}
+		adjTris.resize(tris.size());
+		std::vector<uint32_t> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+		for (size_t i = 0; i < tris.size(); i++)
+		{
+			adjTris[fill[remap[tris[i]]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// Do the cheapest collapses, with each position changing at
+		// most once a pass
+		size_t trisToRemove = (tris.size() - targetIndexCount) / 3;
+		size_t removed = 0;
+		touched.assign(numVerts, 0);
+		for (const Collapse& collapse : collapses)
+		{
+			if (removed >= trisToRemove)
+			{
+				break;
+			}
+			uint32_t from = collapse.mFrom;
+			uint32_t to = remap[collapse.mTo];
+			if (touched[from] || touched[to])
+			{
+				continue;
+			}
+
+			// Don't flip or squash any triangle that stays
+			bool flips = false;
+			Vector3 newPos = pos(collapse.mTo);
+			for (uint32_t j = adjOffsets[from]; j < adjOffsets[from + 1] && !flips; j++)
+			{
+				const uint32_t* tri = &tris[adjTris[j] * 3];
+				if (remap[tri[0]] == to || remap[tri[1]] == to || remap[tri[2]] == to)
+				{
+					// (This one goes away)
+					continue;
+				}
+				Vector3 p[3];
+				Vector3 moved[3];
+				for (int c = 0; c < 3; c++)
+				{
+					p[c] = pos(tri[c]);
+					moved[c] = remap[tri[c]] == from ? newPos : p[c];
+				}
+				Vector3 oldNormal = Vector3::Cross(p[1] - p[0], p[2] - p[0]);
+				Vector3 newNormal = Vector3::Cross(moved[1] - moved[0], moved[2] - moved[0]);
+				flips = newNormal.LengthSq() <= 0.0f || Vector3::Dot(oldNormal, newNormal) <
+					MinNormalDot * oldNormal.Length() * newNormal.Length();
+			}
+			if (flips)
+			{
+				continue;
+			}
+
+			collapsed[from] = collapse.mTo;
+			AddQuadric(quadrics[to], quadrics[from]);
+			touched[from] = 1;
+			touched[to] = 1;
+			// An open edge only has one triangle to lose
+			removed += kinds[from] == EBorder ? 1 : 2;
+			maxCost = Math::Max(maxCost, collapse.mCost);
+		}
+		if (removed == 0)
+		{
+			// Nothing left that can collapse
+			break;
+		}
+
+		// Point triangles at the vertices they collapsed onto, and drop
+		// the ones that lost an edge
+		size_t count = 0;
+		for (size_t i = 0; i < tris.size(); i += 3)
+		{
+			uint32_t v[3];
+			for (int c = 0; c < 3; c++)
+			{
+				v[c] = collapsed[tris[i + c]];
+			}
+			if (remap[v[0]] == remap[v[1]] || remap[v[1]] == remap[v[2]] ||
+				remap[v[0]] == remap[v[2]])
+			{
+				continue;
+			}
+			tris[count++] = v[0];
+			tris[count++] = v[1];
+			tris[count++] = v[2];
+		}
+		tris.resize(count);
+	}
+
+	outIndices.swap(tris);
+	return Math::Sqrt(static_cast<float>(Math::Max(maxCost, 0.0)));
+}
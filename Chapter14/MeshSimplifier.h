@@ -0,0 +1,31 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Reduces the triangles of a mesh by collapsing edges, cheapest first,
+// where the cost is the quadric error metric (squared distance to the
+// planes of the triangles merged into a vertex). Edges collapse onto
+// one of their ends, so the result indexes the original vertices and
+// can share their vertex buffer. Vertices on open edges only move
+// along those edges, and vertices with split attributes (UV/normal
+// seams) don't move at all, so borders and seams keep their shape
+class MeshSimplifier
+{
+public:
+	// Simplify until there are at most targetIndexCount indices, or
+	// nothing else can collapse. Positions are the first three floats
+	// of each vertex, stride floats apart. Returns the error of the
+	// worst collapse (as a distance)
+	static float Simplify(const float* positions, size_t stride, size_t numVerts,
+		const std::vector<uint32_t>& indices, size_t targetIndexCount,
+		std::vector<uint32_t>& outIndices);
+};
@@ -26,8 +26,8 @@ void MirrorCamera::Update(float deltaTime)
 	// Compute ideal position
 	Vector3 idealPos = ComputeCameraPos();
 	// Target is target dist in front of owning actor
-	Vector3 target = mOwner->GetPosition() -
-		mOwner->GetForward() * mTargetDist;
+	Vector3 target = mOwner->GetWorldPosition() -
+		mOwner->GetWorldForward() * mTargetDist;
 	// Use actual position here, not ideal
 	Matrix4 view = Matrix4::CreateLookAt(idealPos, target,
 		Vector3::UnitZ);
@@ -39,8 +39,8 @@ void MirrorCamera::SnapToIdeal()
 {
 	Vector3 idealPos = ComputeCameraPos();
 	// Compute target and view
-	Vector3 target = mOwner->GetPosition() -
-		mOwner->GetForward() * mTargetDist;
+	Vector3 target = mOwner->GetWorldPosition() -
+		mOwner->GetWorldForward() * mTargetDist;
 	// Use actual position here, not ideal
 	Matrix4 view = Matrix4::CreateLookAt(idealPos, target,
 		Vector3::UnitZ);
@@ -69,8 +69,8 @@ void MirrorCamera::SaveProperties(rapidjson::Document::AllocatorType& alloc, rap
 Vector3 MirrorCamera::ComputeCameraPos() const
 {
 	// Set camera position in front of
-	Vector3 cameraPos = mOwner->GetPosition();
-	cameraPos += mOwner->GetForward() * mHorzDist;
+	Vector3 cameraPos = mOwner->GetWorldPosition();
+	cameraPos += mOwner->GetWorldForward() * mHorzDist;
 	cameraPos += Vector3::UnitZ * mVertDist;
 	return cameraPos;
 }
@@ -22,22 +22,22 @@ void MoveComponent::Update(float deltaTime)
 {
 	if (!Math::NearZero(mAngularSpeed))
 	{
-		Quaternion rot = mOwner->GetRotation();
+		Quaternion rot = mOwner->GetWorldRotation();
 		float angle = mAngularSpeed * deltaTime;
 		// Create quaternion for incremental rotation
 		// (Rotate about up axis)
 		Quaternion inc(Vector3::UnitZ, angle);
 		// Concatenate old and new quaternion
 		rot = Quaternion::Concatenate(rot, inc);
-		mOwner->SetRotation(rot);
+		mOwner->SetWorldRotation(rot);
 	}
 	
 	if (!Math::NearZero(mForwardSpeed) || !Math::NearZero(mStrafeSpeed))
 	{
-		Vector3 pos = mOwner->GetPosition();
-		pos += mOwner->GetForward() * mForwardSpeed * deltaTime;
-		pos += mOwner->GetRight() * mStrafeSpeed * deltaTime;
-		mOwner->SetPosition(pos);
+		Vector3 pos = mOwner->GetWorldPosition();
+		pos += mOwner->GetWorldForward() * mForwardSpeed * deltaTime;
+		pos += mOwner->GetWorldRight() * mStrafeSpeed * deltaTime;
+		mOwner->SetWorldPosition(pos);
 	}
 }
 
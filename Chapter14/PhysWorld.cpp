@@ -7,6 +7,7 @@
 // ----------------------------------------------------------------
 
 #include "PhysWorld.h"
+#include "Profiler.h"
 #include <algorithm>
 #include "BoxComponent.h"
 #include <SDL/SDL.h>
@@ -18,6 +19,7 @@ PhysWorld::PhysWorld(Game* game)
 
 bool PhysWorld::SegmentCast(const LineSegment& l, CollisionInfo& outColl)
 {
+	PROFILE_SCOPE("PhysWorld::SegmentCast");
 	bool collided = false;
 	// Initialize closestT to infinity, so first
 	// intersection will always update closestT
@@ -47,6 +49,7 @@ bool PhysWorld::SegmentCast(const LineSegment& l, CollisionInfo& outColl)
 
 void PhysWorld::TestPairwise(std::function<void(Actor*, Actor*)> f)
 {
+	PROFILE_SCOPE("PhysWorld::TestPairwise");
 	// Naive implementation O(n^2)
 	for (size_t i = 0; i < mBoxes.size(); i++)
 	{
@@ -66,12 +69,18 @@ void PhysWorld::TestPairwise(std::function<void(Actor*, Actor*)> f)
 
 void PhysWorld::TestSweepAndPrune(std::function<void(Actor*, Actor*)> f)
 {
+	PROFILE_SCOPE("PhysWorld::TestSweepAndPrune");
 	// Sort by min.x
 	std::sort(mBoxes.begin(), mBoxes.end(),
 		[](BoxComponent* a, BoxComponent* b) {
 			return a->GetWorldBox().mMin.x <
 				b->GetWorldBox().mMin.x;
 	});
+	// Sorting moved the boxes, so update their indices
+	for (size_t i = 0; i < mBoxes.size(); i++)
+	{
+		mBoxes[i]->SetSystemIndex(static_cast<int>(i));
+	}
 
 	for (size_t i = 0; i < mBoxes.size(); i++)
 	{
@@ -98,16 +107,20 @@ void PhysWorld::TestSweepAndPrune(std::function<void(Actor*, Actor*)> f)
 
 void PhysWorld::AddBox(BoxComponent* box)
 {
+	box->SetSystemIndex(static_cast<int>(mBoxes.size()));
 	mBoxes.emplace_back(box);
 }
 
 void PhysWorld::RemoveBox(BoxComponent* box)
 {
-	auto iter = std::find(mBoxes.begin(), mBoxes.end(), box);
-	if (iter != mBoxes.end())
+	int index = box->GetSystemIndex();
+	if (index >= 0)
 	{
-		// Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mBoxes.end() - 1);
+		// Swap the last box into this one's place and pop off
+		BoxComponent* last = mBoxes.back();
+		mBoxes[index] = last;
+		last->SetSystemIndex(index);
 		mBoxes.pop_back();
+		box->SetSystemIndex(-1);
 	}
 }
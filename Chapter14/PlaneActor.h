@@ -13,5 +13,6 @@ class PlaneActor : public Actor
 {
 public:
 	PlaneActor(class Game* game);
-	TypeID GetType() const override { return TPlaneActor; }
+	static const TypeID StaticType = TPlaneActor;
+	TypeID GetType() const override { return StaticType; }
 };
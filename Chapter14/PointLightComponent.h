@@ -16,8 +16,8 @@ public:
 	PointLightComponent(class Actor* owner);
 	~PointLightComponent();
 
-	// Draw this point light as geometry
-	void Draw(class Shader* shader, class Mesh* mesh);
+	void OnRecycle() override;
+	void OnReuse() override;
 
 	// Diffuse color
 	Vector3 mDiffuseColor;
@@ -0,0 +1,130 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "PoolAllocator.h"
+#include "JobSystem.h"
+#include <SDL/SDL_assert.h>
+#include <new>
+#include <vector>
+#include <thread>
+
+namespace
+{
+	// Every block is a multiple of this (which also keeps blocks aligned)
+	const size_t Granularity = 16;
+	const size_t NumSizeClasses = PoolAllocator::MaxPooledSize / Granularity;
+	// Size of each chunk requested from the heap
+	const size_t ChunkSize = 64 * 1024;
+
+	// Free blocks store a pointer to the next free block
+	struct FreeBlock
+	{
+		FreeBlock* mNext;
+	};
+
+	struct Pools
+	{
+		Pools()
+			:mThread(std::this_thread::get_id())
+		{
+			for (size_t i = 0; i < NumSizeClasses; i++)
+			{
+				mFreeLists[i] = nullptr;
+			}
+		}
+
+		~Pools()
+		{
+			for (void* chunk : mChunks)
+			{
+				::operator delete(chunk);
+			}
+		}
+
+		FreeBlock* mFreeLists[NumSizeClasses];
+		std::vector<void*> mChunks;
+		// Thread that first used the pools (the main thread)
+		std::thread::id mThread;
+	};
+
+	// (Function static so it's ready before any global objects use it)
+	Pools& GetPools()
+	{
+		static Pools pools;
+		return pools;
+	}
+
+	size_t GetSizeClass(size_t size)
+	{
+		return (size + Granularity - 1) / Granularity - 1;
+	}
+
+	// (Job workers have a nonzero index, but other threads, like the
+	// render thread, are 0 too, so also check the thread itself)
+	bool IsMainThread(const Pools& pools)
+	{
+		return JobSystem::GetThreadIndex() == 0 &&
+			pools.mThread == std::this_thread::get_id();
+	}
+}
+
+void* PoolAllocator::Allocate(size_t size)
+{
+	if (size == 0 || size > MaxPooledSize)
+	{
+		return ::operator new(size);
+	}
+
+	Pools& pools = GetPools();
+	SDL_assert(IsMainThread(pools));
+	size_t sizeClass = GetSizeClass(size);
+	FreeBlock*& freeList = pools.mFreeLists[sizeClass];
+	if (freeList == nullptr)
+	{
+		// Out of blocks, so carve a new chunk into blocks of this size
+		size_t blockSize = (sizeClass + 1) * Granularity;
+		size_t numBlocks = ChunkSize / blockSize;
+		char* chunk = static_cast<char*>(::operator new(blockSize * numBlocks));
+		pools.mChunks.emplace_back(chunk);
+		for (size_t i = 0; i < numBlocks; i++)
+		{
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+			block->mNext = freeList;
+			freeList = block;
+		}
+	}
+
+	FreeBlock* block = freeList;
+	freeList = block->mNext;
+	return block;
+}
+
+void PoolAllocator::Free(void* ptr, size_t size)
+{
+	if (ptr == nullptr)
+	{
+		return;
+	}
+	if (size == 0 || size > MaxPooledSize)
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+	Pools& pools = GetPools();
+	SDL_assert(IsMainThread(pools));
+	FreeBlock* block = static_cast<FreeBlock*>(ptr);
+	FreeBlock*& freeList = pools.mFreeLists[GetSizeClass(size)];
+	block->mNext = freeList;
+	freeList = block;
+}
+
+size_t PoolAllocator::GetNumChunks()
+{
+	return GetPools().mChunks.size();
+}
@@ -0,0 +1,30 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+
+// Allocates small objects out of large chunks, with one free list
+// per size class (so freed memory is reused by the next allocation
+// of a similar size, rather than going back to the heap).
+// Main thread only: there's no locking, so jobs that need to create
+// or destroy actors/components have to defer it to the main thread
+// (as CommandBuffer does)
+class PoolAllocator
+{
+public:
+	// Sizes above this just use the regular heap
+	static const size_t MaxPooledSize = 1024;
+
+	static void* Allocate(size_t size);
+	// Size must match what was passed to Allocate
+	static void Free(void* ptr, size_t size);
+
+	// Number of chunks that have come from the heap so far
+	static size_t GetNumChunks();
+};
@@ -0,0 +1,201 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "Profiler.h"
+#include "JobSystem.h"
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <SDL/SDL.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+namespace
+{
+	// Scopes kept per thread (older ones are overwritten)
+	const uint64_t EventsPerThread = 32768;
+	// Frame start times kept
+	const uint64_t MaxFrameStarts = Profiler::MaxFrames;
+	// Named threads get trace thread ids from here up
+	// (so they don't collide with worker indices)
+	const int FirstNamedThreadID = 1000;
+
+	struct Event
+	{
+		const char* mName;
+		uint64_t mStart;
+		uint64_t mEnd;
+	};
+
+	struct ThreadBuffer
+	{
+		ThreadBuffer(int threadIndex)
+			:mEvents(EventsPerThread)
+			,mCount(0)
+			,mThreadIndex(threadIndex)
+			,mName(nullptr)
+		{
+		}
+
+		std::vector<Event> mEvents;
+		// Total events ever recorded (only written by the owning thread)
+		std::atomic<uint64_t> mCount;
+		int mThreadIndex;
+		// nullptr for the main thread/workers
+		const char* mName;
+	};
+
+	// Every thread's buffer, so they can all be dumped
+	std::vector<ThreadBuffer*> sBuffers;
+	std::mutex sBuffersMutex;
+	thread_local ThreadBuffer* sThreadBuffer = nullptr;
+	std::atomic<int> sNumNamedThreads(0);
+
+	uint64_t sFrameStarts[MaxFrameStarts];
+	uint64_t sFrameCount = 0;
+
+	ThreadBuffer* GetThreadBuffer()
+	{
+		if (!sThreadBuffer)
+		{
+			// First scope on this thread, so make its buffer
+			sThreadBuffer = new ThreadBuffer(JobSystem::GetThreadIndex());
+			std::lock_guard<std::mutex> lock(sBuffersMutex);
+			sBuffers.emplace_back(sThreadBuffer);
+		}
+		return sThreadBuffer;
+	}
+}
+
+uint64_t Profiler::GetTime()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t end)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	uint64_t count = buffer->mCount.load(std::memory_order_relaxed);
+	Event& e = buffer->mEvents[count % EventsPerThread];
+	e.mName = name;
+	e.mStart = start;
+	e.mEnd = end;
+	// (Release, so a dump on another thread sees the whole event)
+	buffer->mCount.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::BeginFrame()
+{
+	sFrameStarts[sFrameCount % MaxFrameStarts] = GetTime();
+	sFrameCount++;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(sBuffersMutex);
+	buffer->mName = name;
+	buffer->mThreadIndex = FirstNamedThreadID + sNumNamedThreads++;
+}
+
+bool Profiler::DumpChromeTrace(const std::string& fileName, int numFrames)
+{
+	if (sFrameCount == 0 || numFrames <= 0)
+	{
+		return false;
+	}
+
+	// Only keep scopes that started in the last numFrames frames
+	uint64_t frames = static_cast<uint64_t>(numFrames);
+	frames = frames < sFrameCount ? frames : sFrameCount;
+	frames = frames < MaxFrameStarts ? frames : MaxFrameStarts;
+	uint64_t firstFrame = sFrameCount - frames;
+	uint64_t cutoff = sFrameStarts[firstFrame % MaxFrameStarts];
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("traceEvents");
+	writer.StartArray();
+
+	// Frame markers
+	for (uint64_t frame = firstFrame; frame < sFrameCount; frame++)
+	{
+		std::string name = "Frame " + std::to_string(frame);
+		writer.StartObject();
+		writer.Key("name"); writer.String(name.c_str());
+		writer.Key("ph"); writer.String("i");
+		writer.Key("s"); writer.String("g");
+		writer.Key("ts"); writer.Double((sFrameStarts[frame % MaxFrameStarts] - cutoff) / 1000.0);
+		writer.Key("pid"); writer.Int(0);
+		writer.Key("tid"); writer.Int(0);
+		writer.EndObject();
+	}
+
+	std::lock_guard<std::mutex> lock(sBuffersMutex);
+	for (ThreadBuffer* threadBuffer : sBuffers)
+	{
+		// Name the thread
+		std::string threadName = "Main thread";
+		if (threadBuffer->mName)
+		{
+			threadName = threadBuffer->mName;
+		}
+		else if (threadBuffer->mThreadIndex > 0)
+		{
+			threadName = "Worker " + std::to_string(threadBuffer->mThreadIndex);
+		}
+		writer.StartObject();
+		writer.Key("name"); writer.String("thread_name");
+		writer.Key("ph"); writer.String("M");
+		writer.Key("pid"); writer.Int(0);
+		writer.Key("tid"); writer.Int(threadBuffer->mThreadIndex);
+		writer.Key("args");
+		writer.StartObject();
+		writer.Key("name"); writer.String(threadName.c_str());
+		writer.EndObject();
+		writer.EndObject();
+
+		// Then its scopes, oldest first
+		uint64_t count = threadBuffer->mCount.load(std::memory_order_acquire);
+		uint64_t first = count > EventsPerThread ? count - EventsPerThread : 0;
+		for (uint64_t i = first; i < count; i++)
+		{
+			const Event& e = threadBuffer->mEvents[i % EventsPerThread];
+			if (e.mStart < cutoff)
+			{
+				continue;
+			}
+			writer.StartObject();
+			writer.Key("name"); writer.String(e.mName);
+			writer.Key("ph"); writer.String("X");
+			writer.Key("ts"); writer.Double((e.mStart - cutoff) / 1000.0);
+			writer.Key("dur"); writer.Double((e.mEnd - e.mStart) / 1000.0);
+			writer.Key("pid"); writer.Int(0);
+			writer.Key("tid"); writer.Int(threadBuffer->mThreadIndex);
+			writer.EndObject();
+		}
+	}
+
+	writer.EndArray();
+	writer.EndObject();
+
+	std::ofstream outFile(fileName);
+	if (!outFile.is_open())
+	{
+		SDL_Log("Failed to write profile %s", fileName.c_str());
+		return false;
+	}
+	outFile << buffer.GetString();
+	SDL_Log("Wrote last %d frames of profile to %s",
+		static_cast<int>(frames), fileName.c_str());
+	return true;
+}
@@ -0,0 +1,62 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Records timed scopes from every thread into per-thread ring
+// buffers, which can be dumped as Chrome trace events JSON
+// (open with chrome://tracing or https://ui.perfetto.dev)
+class Profiler
+{
+public:
+	// Most frames that can be dumped at once
+	static const int MaxFrames = 256;
+
+	// Current time in nanoseconds
+	static uint64_t GetTime();
+	// Save a finished scope for the calling thread
+	// (name must stay valid, so it should be a string literal
+	// or otherwise live as long as the program does)
+	static void Record(const char* name, uint64_t start, uint64_t end);
+	// Mark the start of a new frame (main thread only)
+	static void BeginFrame();
+	// Name the calling thread, for threads besides the main thread
+	// and job workers (call before it records any scopes)
+	static void SetThreadName(const char* name);
+	// Write out everything from the last numFrames frames
+	static bool DumpChromeTrace(const std::string& fileName, int numFrames);
+};
+
+// Times from construction until the end of the enclosing scope
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name)
+		:mName(name)
+		,mStart(Profiler::GetTime())
+	{
+	}
+	~ProfileScope()
+	{
+		Profiler::Record(mName, mStart, Profiler::GetTime());
+	}
+private:
+	const char* mName;
+	uint64_t mStart;
+};
+
+// Define NO_PROFILER to compile out all the scopes
+#ifdef NO_PROFILER
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_SCOPE_JOIN2(a, b) a##b
+#define PROFILE_SCOPE_JOIN(a, b) PROFILE_SCOPE_JOIN2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_SCOPE_JOIN(profileScope, __LINE__)(name)
+#endif
@@ -0,0 +1,56 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "RenderPacket.h"
+
+RenderPacket::RenderPacket()
+	:mFence(nullptr)
+	,mInUse(false)
+{
+}
+
+void RenderPacket::Clear()
+{
+	// (Keeps the lists' memory, since every frame needs about as much)
+	mMeshDraws.clear();
+	mTransforms.clear();
+	mPalettes.clear();
+	mSprites.mVertices.clear();
+	mSprites.mRuns.clear();
+	mFence = nullptr;
+}
+
+void RenderPacket::AddMesh(const RenderQueue::DrawItem& item, float depth,
+	const Matrix4& world, const MatrixPalette* palette)
+{
+	MeshDraw draw;
+	draw.mItem = item;
+	draw.mDepth = depth;
+	draw.mTransform = mTransforms.size();
+	draw.mPalette = -1;
+	mTransforms.emplace_back(world);
+	if (palette)
+	{
+		draw.mPalette = static_cast<int>(mPalettes.size());
+		mPalettes.emplace_back(*palette);
+	}
+	mMeshDraws.emplace_back(draw);
+}
+
+RenderQueue::DrawItem RenderPacket::GetDrawItem(size_t i) const
+{
+	const MeshDraw& draw = mMeshDraws[i];
+	RenderQueue::DrawItem item = draw.mItem;
+	item.mWorldTransform = &mTransforms[draw.mTransform];
+	item.mPalette = nullptr;
+	if (draw.mPalette >= 0)
+	{
+		item.mPalette = mPalettes[draw.mPalette].mEntry;
+	}
+	return item;
+}
@@ -0,0 +1,69 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include "Math.h"
+#include "MatrixPalette.h"
+#include "RenderQueue.h"
+#include "SpriteBatch.h"
+#include "LightGrid.h"
+#include "Renderer.h"
+
+// Everything needed to draw a frame, copied out of the components on
+// the game thread, so the render thread can draw it while the game
+// moves on to the next frame. Nothing in it points at components
+// (only at assets and shaders, which outlive every packet)
+struct RenderPacket
+{
+	// A mesh draw, with its transforms kept in the packet
+	struct MeshDraw
+	{
+		// (Its world transform/palette are filled in by GetDrawItem)
+		RenderQueue::DrawItem mItem;
+		// View space depth, for sorting
+		float mDepth;
+		// Index in mTransforms
+		size_t mTransform;
+		// Index in mPalettes, or -1 if not skinned
+		int mPalette;
+	};
+
+	RenderPacket();
+
+	// Empty everything, to build the next frame
+	void Clear();
+	// Add a mesh draw, copying its world transform/palette
+	void AddMesh(const RenderQueue::DrawItem& item, float depth,
+		const Matrix4& world, const MatrixPalette* palette = nullptr);
+	// Draw item for mesh draw i, pointing at this packet's copies
+	RenderQueue::DrawItem GetDrawItem(size_t i) const;
+
+	// Camera and lighting
+	Matrix4 mView;
+	Matrix4 mMirrorView;
+	Matrix4 mProjection;
+	Vector3 mAmbientLight;
+	DirectionalLight mDirLight;
+
+	// Visible meshes in the main view
+	std::vector<MeshDraw> mMeshDraws;
+	std::vector<Matrix4> mTransforms;
+	std::vector<MatrixPalette> mPalettes;
+	// Visible point lights, binned into tiles
+	LightGrid::Lists mLights;
+	// Sprite and UI quads
+	SpriteBatch::Frame mSprites;
+
+	// Signaled once GL work the game thread did while building this
+	// (like streamed in textures) is done (a GLsync, or nullptr)
+	struct __GLsync* mFence;
+	// True from when it's queued until the render thread is done
+	// (guarded by the renderer's packet mutex)
+	bool mInUse;
+};
@@ -0,0 +1,327 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "RenderQueue.h"
+#include "Profiler.h"
+#include "Shader.h"
+#include "VertexArray.h"
+#include <GL/glew.h>
+
+namespace
+{
+	// Sort key layout, from the most significant bit down:
+	// pass (4) | shader (8) | vertex array (16) | texture (16) | depth (20)
+	// IDs that don't fit are truncated, which can only make the sort
+	// group things less well (Submit compares the real pointers).
+	// LODs aren't in the key, but sorting by depth keeps each mesh's
+	// LODs mostly in runs anyway (nearer ones are more detailed)
+	const int DepthBits = 20;
+	const int TextureShift = DepthBits;
+	const int VertexArrayShift = TextureShift + 16;
+	const int ShaderShift = VertexArrayShift + 16;
+	const int PassShift = ShaderShift + 8;
+
+	// Depths past this all sort the same (matches the far plane)
+	const float MaxSortDepth = 10000.0f;
+
+	// Per instance attributes (world transform rows, then spec power)
+	const unsigned int NumInstanceAttribs = 5;
+
+	// Uniforms set for every draw
+	const uint32_t WorldTransformName = Shader::HashName("uWorldTransform");
+	const uint32_t MatrixPaletteName = Shader::HashName("uMatrixPalette");
+	const uint32_t SpecPowerName = Shader::HashName("uSpecPower");
+	const uint32_t PosScaleName = Shader::HashName("uPosScale");
+	const uint32_t PosOffsetName = Shader::HashName("uPosOffset");
+}
+
+RenderQueue::RenderQueue()
+	:mInstanceBuffer(0)
+	,mStats()
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+	if (mInstanceBuffer != 0)
+	{
+		glDeleteBuffers(1, &mInstanceBuffer);
+	}
+}
+
+void RenderQueue::SetInstancedShader(Shader* shader, Shader* instanced)
+{
+	mInstancedShaders.emplace_back(shader, instanced);
+}
+
+Shader* RenderQueue::GetInstancedShader(Shader* shader) const
+{
+	for (auto& pair : mInstancedShaders)
+	{
+		if (pair.first == shader)
+		{
+			return pair.second;
+		}
+	}
+	return nullptr;
+}
+
+void RenderQueue::Clear()
+{
+	mItems.clear();
+	mKeys.clear();
+}
+
+void RenderQueue::Add(const DrawItem& item, float depth, Pass pass)
+{
+	SortKey key;
+	key.mKey = MakeKey(item, depth, pass);
+	key.mIndex = static_cast<uint32_t>(mItems.size());
+	mKeys.emplace_back(key);
+	mItems.emplace_back(item);
+}
+
+uint64_t RenderQueue::MakeKey(const DrawItem& item, float depth, Pass pass) const
+{
+	const uint64_t maxDepth = (1ull << DepthBits) - 1;
+	float normDepth = Math::Clamp(depth / MaxSortDepth, 0.0f, 1.0f);
+	uint64_t depthBits = static_cast<uint64_t>(normDepth * maxDepth);
+	if (pass == ETranslucentPass)
+	{
+		// Back to front
+		depthBits = maxDepth - depthBits;
+	}
+
+	uint64_t texture = item.mTextureID;
+	uint64_t key = static_cast<uint64_t>(pass & 0xf) << PassShift;
+	key |= static_cast<uint64_t>(item.mShader->GetProgramID() & 0xff) << ShaderShift;
+	key |= static_cast<uint64_t>(item.mVertexArray->GetArrayID() & 0xffff) << VertexArrayShift;
+	key |= (texture & 0xffff) << TextureShift;
+	key |= depthBits;
+	return key;
+}
+
+void RenderQueue::Sort()
+{
+	// LSD radix sort, a byte at a time
+	const size_t count = mKeys.size();
+	size_t histograms[8][256] = {};
+	for (const SortKey& k : mKeys)
+	{
+		for (int b = 0; b < 8; b++)
+		{
+			histograms[b][(k.mKey >> (b * 8)) & 0xff]++;
+		}
+	}
+
+	mSortTemp.resize(count);
+	for (int b = 0; b < 8; b++)
+	{
+		size_t* histogram = histograms[b];
+		// Skip bytes that are the same for every key
+		// (common, since most of the key is IDs that repeat)
+		if (histogram[(mKeys[0].mKey >> (b * 8)) & 0xff] == count)
+		{
+			continue;
+		}
+
+		// Turn counts into starting offsets
+		size_t offset = 0;
+		for (int i = 0; i < 256; i++)
+		{
+			size_t c = histogram[i];
+			histogram[i] = offset;
+			offset += c;
+		}
+
+		for (const SortKey& k : mKeys)
+		{
+			mSortTemp[histogram[(k.mKey >> (b * 8)) & 0xff]++] = k;
+		}
+		mKeys.swap(mSortTemp);
+	}
+}
+
+void RenderQueue::BuildBatches()
+{
+	mBatches.clear();
+	mInstanceData.clear();
+	const size_t count = mKeys.size();
+	size_t i = 0;
+	while (i < count)
+	{
+		const DrawItem& first = mItems[mKeys[i].mIndex];
+		Batch batch;
+		batch.mFirst = i;
+		batch.mCount = 1;
+		batch.mInstancedShader = nullptr;
+		batch.mFirstInstance = 0;
+
+		// Skinned meshes need their own palette, so can't be instanced
+		Shader* instanced = first.mPalette ? nullptr : GetInstancedShader(first.mShader);
+		if (instanced)
+		{
+			// Sorting put everything with the same state next to each other
+			size_t end = i + 1;
+			while (end < count)
+			{
+				const DrawItem& item = mItems[mKeys[end].mIndex];
+				if (item.mShader != first.mShader ||
+					item.mVertexArray != first.mVertexArray ||
+					item.mTextureID != first.mTextureID ||
+					item.mFirstIndex != first.mFirstIndex ||
+					item.mPalette)
+				{
+					break;
+				}
+				end++;
+			}
+
+			// (A single draw is cheaper without instancing)
+			if (end - i > 1)
+			{
+				batch.mCount = end - i;
+				batch.mInstancedShader = instanced;
+				batch.mFirstInstance = mInstanceData.size();
+				for (size_t j = i; j < end; j++)
+				{
+					const DrawItem& item = mItems[mKeys[j].mIndex];
+					InstanceData data;
+					data.mWorldTransform = *item.mWorldTransform;
+					data.mSpecPower = item.mSpecPower;
+					mInstanceData.emplace_back(data);
+				}
+			}
+		}
+		mBatches.emplace_back(batch);
+		i += batch.mCount;
+	}
+}
+
+void RenderQueue::Submit()
+{
+	PROFILE_SCOPE("RenderQueue::Submit");
+	mStats = Stats();
+	if (mKeys.empty())
+	{
+		return;
+	}
+	Sort();
+	BuildBatches();
+
+	// Upload every instance for this submit at once
+	if (!mInstanceData.empty())
+	{
+		if (mInstanceBuffer == 0)
+		{
+			glGenBuffers(1, &mInstanceBuffer);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+		// (Orphans last submit's data, so this doesn't wait on it)
+		glBufferData(GL_ARRAY_BUFFER, mInstanceData.size() * sizeof(InstanceData),
+			mInstanceData.data(), GL_STREAM_DRAW);
+	}
+
+	Shader* shader = nullptr;
+	VertexArray* va = nullptr;
+	bool vaInstanced = false;
+	unsigned int texture = 0;
+	float specPower = 0.0f;
+	for (const Batch& batch : mBatches)
+	{
+		const DrawItem& item = mItems[mKeys[batch.mFirst].mIndex];
+		Shader* batchShader = batch.mInstancedShader ?
+			batch.mInstancedShader : item.mShader;
+		bool newShader = batchShader != shader;
+		if (newShader)
+		{
+			shader = batchShader;
+			shader->SetActive();
+			mStats.mShaderBinds++;
+			// Uniforms belong to the program, so set spec power again
+			if (!batch.mInstancedShader)
+			{
+				specPower = item.mSpecPower;
+				shader->SetFloatUniform(SpecPowerName, specPower);
+			}
+		}
+		else if (!batch.mInstancedShader && item.mSpecPower != specPower)
+		{
+			specPower = item.mSpecPower;
+			shader->SetFloatUniform(SpecPowerName, specPower);
+		}
+		// (Instanced draws use the mesh's other vertex array object,
+		// so the per instance attributes never touch its regular one)
+		bool instanced = batch.mInstancedShader != nullptr;
+		bool newArray = item.mVertexArray != va || instanced != vaInstanced;
+		if (newArray)
+		{
+			va = item.mVertexArray;
+			vaInstanced = instanced;
+			if (instanced)
+			{
+				va->SetActiveInstanced(NumInstanceAttribs);
+			}
+			else
+			{
+				va->SetActive();
+			}
+			mStats.mVertexArrayBinds++;
+		}
+		if (newShader || newArray)
+		{
+			// How to unpack this vertex array's positions
+			// (set again for a new shader, since uniforms are per program)
+			shader->SetVectorUniform(PosScaleName, va->GetPositionScale());
+			shader->SetVectorUniform(PosOffsetName, va->GetPositionOffset());
+		}
+		if (item.mTextureID != 0 && item.mTextureID != texture)
+		{
+			texture = item.mTextureID;
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			mStats.mTextureBinds++;
+		}
+
+		const void* firstIndex = reinterpret_cast<const void*>(
+			static_cast<size_t>(item.mFirstIndex) * va->GetIndexSize());
+		int triangles = static_cast<int>(item.mNumIndices / 3);
+		if (batch.mInstancedShader)
+		{
+			// Point the instance attributes at the batch
+			// (they're already enabled, with a divisor of 1)
+			glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+			size_t offset = batch.mFirstInstance * sizeof(InstanceData);
+			for (GLuint row = 0; row < 4; row++)
+			{
+				glVertexAttribPointer(3 + row, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+					reinterpret_cast<void*>(offset + sizeof(float) * 4 * row));
+			}
+			glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+				reinterpret_cast<void*>(offset + sizeof(Matrix4)));
+
+			glDrawElementsInstanced(GL_TRIANGLES, item.mNumIndices, va->GetIndexType(),
+				firstIndex, static_cast<GLsizei>(batch.mCount));
+			mStats.mInstancedDraws++;
+			mStats.mInstances += static_cast<int>(batch.mCount);
+			mStats.mTriangles += triangles * static_cast<int>(batch.mCount);
+		}
+		else
+		{
+			shader->SetMatrixUniform(WorldTransformName, *item.mWorldTransform);
+			if (item.mPalette)
+			{
+				shader->SetMatrixUniforms(MatrixPaletteName, item.mPalette,
+					item.mPaletteSize);
+			}
+			glDrawElements(GL_TRIANGLES, item.mNumIndices, va->GetIndexType(), firstIndex);
+			mStats.mTriangles += triangles;
+		}
+		mStats.mDraws++;
+	}
+}
@@ -0,0 +1,119 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "Math.h"
+
+// Collects mesh draws for a pass, sorts them by a 64-bit key so
+// draws that share GL state end up next to each other, and then
+// submits them, only changing state that actually differs.
+// Runs of draws with the same mesh and texture are drawn as one
+// instanced draw, if their shader has an instanced version
+class RenderQueue
+{
+public:
+	enum Pass
+	{
+		// Sorted front to back, to get the most out of the depth test
+		EOpaquePass,
+		// Sorted back to front, so blending is correct
+		ETranslucentPass
+	};
+
+	// Everything needed to issue one draw
+	struct DrawItem
+	{
+		class Shader* mShader;
+		class VertexArray* mVertexArray;
+		// Range of the index buffer to draw (the mesh's LOD)
+		unsigned int mFirstIndex;
+		unsigned int mNumIndices;
+		// GL texture (0 for none)
+		unsigned int mTextureID;
+		// (Must stay valid until Submit)
+		const Matrix4* mWorldTransform;
+		// Skinned meshes only (otherwise nullptr)
+		const Matrix4* mPalette;
+		unsigned int mPaletteSize;
+		float mSpecPower;
+	};
+
+	// How much state Submit had to change
+	// (written by whichever thread submits)
+	struct Stats
+	{
+		int mDraws;
+		int mInstancedDraws;
+		int mInstances;
+		int mTriangles;
+		int mShaderBinds;
+		int mVertexArrayBinds;
+		int mTextureBinds;
+	};
+
+	RenderQueue();
+	~RenderQueue();
+
+	// Use instanced for runs of draws that would use shader
+	// (its per instance attributes must match InstanceData)
+	void SetInstancedShader(class Shader* shader, class Shader* instanced);
+	// Remove all items (call before building each pass)
+	void Clear();
+	// Add a draw, with depth as its view space distance
+	void Add(const DrawItem& item, float depth, Pass pass = EOpaquePass);
+	// Sort and issue every draw added since the last Clear
+	void Submit();
+
+	const Stats& GetStats() const { return mStats; }
+private:
+	uint64_t MakeKey(const DrawItem& item, float depth, Pass pass) const;
+	// Radix sort mKeys (and their item indices)
+	void Sort();
+	// Split the sorted items into batches, and fill in mInstanceData
+	void BuildBatches();
+	class Shader* GetInstancedShader(class Shader* shader) const;
+
+	struct SortKey
+	{
+		uint64_t mKey;
+		uint32_t mIndex;
+	};
+
+	// Per instance vertex attributes (locations 3-7)
+	struct InstanceData
+	{
+		Matrix4 mWorldTransform;
+		float mSpecPower;
+	};
+
+	// Sorted items drawn with one draw call
+	struct Batch
+	{
+		size_t mFirst;
+		size_t mCount;
+		// nullptr unless drawn instanced
+		class Shader* mInstancedShader;
+		// Index of the first instance in mInstanceData
+		size_t mFirstInstance;
+	};
+
+	std::vector<DrawItem> mItems;
+	std::vector<SortKey> mKeys;
+	// Scratch space for the radix sort
+	std::vector<SortKey> mSortTemp;
+	std::vector<Batch> mBatches;
+	std::vector<InstanceData> mInstanceData;
+	// (Shader, instanced version) pairs
+	std::vector<std::pair<class Shader*, class Shader*>> mInstancedShaders;
+	// Streamed every Submit
+	unsigned int mInstanceBuffer;
+	Stats mStats;
+};
@@ -7,6 +7,7 @@
 // ----------------------------------------------------------------
 
 #include "Renderer.h"
+#include "Profiler.h"
 #include "Texture.h"
 #include "Mesh.h"
 #include <algorithm>
@@ -20,18 +21,74 @@
 #include "SkeletalMeshComponent.h"
 #include "GBuffer.h"
 #include "PointLightComponent.h"
+#include "Collision.h"
+#include "Actor.h"
+#include "RenderQueue.h"
+#include "LightGrid.h"
+#include "JobSystem.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+#include "AssetLoader.h"
+#include "RenderPacket.h"
+
+namespace
+{
+	// Skinned vertices can move outside the bind pose bounds,
+	// so their bounding spheres are scaled up by this much
+	const float SkinnedBoundsScale = 1.5f;
+
+	// Time each frame can spend creating streamed in assets
+	const float AssetUploadBudgetMS = 2.0f;
+	// Streaming textures show this until they're loaded
+	const char* PlaceholderTexture = "Assets/Default.png";
+
+	// Box containing the transformed box
+	AABB TransformBox(const AABB& box, const Matrix4& m)
+	{
+		Vector3 center = (box.mMin + box.mMax) * 0.5f;
+		Vector3 extents = (box.mMax - box.mMin) * 0.5f;
+		Vector3 newCenter = Vector3::Transform(center, m);
+		Vector3 newExtents(
+			Math::Abs(m.mat[0][0]) * extents.x + Math::Abs(m.mat[1][0]) * extents.y +
+				Math::Abs(m.mat[2][0]) * extents.z,
+			Math::Abs(m.mat[0][1]) * extents.x + Math::Abs(m.mat[1][1]) * extents.y +
+				Math::Abs(m.mat[2][1]) * extents.z,
+			Math::Abs(m.mat[0][2]) * extents.x + Math::Abs(m.mat[1][2]) * extents.y +
+				Math::Abs(m.mat[2][2]) * extents.z);
+		return AABB(newCenter - newExtents, newCenter + newExtents);
+	}
+}
 
 Renderer::Renderer(Game* game)
-	:mGame(game)
+	:mAtlas(nullptr)
+	,mAssetLoader(nullptr)
+	,mSpritesNeedSort(false)
+	,mGame(game)
 	,mSpriteShader(nullptr)
+	,mSpriteVerts(nullptr)
+	,mSpriteBatch(nullptr)
 	,mMeshShader(nullptr)
+	,mMeshInstancedShader(nullptr)
 	,mSkinnedShader(nullptr)
+	,mWindow(nullptr)
+	,mHeadless(false)
 	,mMirrorBuffer(0)
 	,mMirrorTexture(nullptr)
 	,mGBuffer(nullptr)
 	,mGGlobalShader(nullptr)
-	,mGPointLightShader(nullptr)
+	,mLightGrid(nullptr)
+	,mCullStats()
+	,mRenderQueue(nullptr)
+	,mFrameDataBuffer(0)
+	,mFrameDataStride(0)
+	,mLoadContext(nullptr)
+	,mNextPacket(0)
+	,mStopRenderThread(false)
 {
+	for (int i = 0; i < NumPackets; i++)
+	{
+		mPackets[i] = nullptr;
+	}
 }
 
 Renderer::~Renderer()
@@ -43,6 +100,13 @@ bool Renderer::Initialize(float screenWidth, float screenHeight)
 	mScreenWidth = screenWidth;
 	mScreenHeight = screenHeight;
 
+	mHeadless = mGame->IsHeadless();
+	if (mHeadless)
+	{
+		// No window or GL
+		return true;
+	}
+
 	// Set OpenGL attributes
 	// Use the core OpenGL profile
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
@@ -92,6 +156,22 @@ bool Renderer::Initialize(float screenWidth, float screenHeight)
 
 	// Create quad for drawing sprites
 	CreateSpriteVerts();
+	mSpriteBatch = new SpriteBatch();
+	if (!mSpriteBatch->Create())
+	{
+		SDL_Log("Failed to create sprite batch.");
+		return false;
+	}
+
+	// Pack the UI textures, so they can draw without rebinding
+	// (anything that fails to pack still loads on its own)
+	mAtlas = new TextureAtlas();
+	mAtlas->Load("Assets/UI.gpatlas");
+
+	mAssetLoader = new AssetLoader(this, mGame->GetJobSystem());
+
+	mRenderQueue = new RenderQueue();
+	mRenderQueue->SetInstancedShader(mMeshShader, mMeshInstancedShader);
 
 	// Create render target for mirror
 	//if (!CreateMirrorTarget())
@@ -104,20 +184,41 @@ bool Renderer::Initialize(float screenWidth, float screenHeight)
 	mGBuffer = new GBuffer();
 	int width = static_cast<int>(mScreenWidth);
 	int height = static_cast<int>(mScreenHeight);
-	if (!mGBuffer->Create(width, height))
+	GBuffer::Layout layout = mGame->UseCompactGBuffer() ?
+		GBuffer::ECompactLayout : GBuffer::EWorldPosLayout;
+	if (!mGBuffer->Create(width, height, layout))
 	{
 		SDL_Log("Failed to create G-buffer.");
 		return false;
 	}
 
-	// Load point light mesh
-	mPointLightMesh = GetMesh("Assets/PointLight.gpmesh");
+	// Create tiles for point lights
+	mLightGrid = new LightGrid();
+	if (!mLightGrid->Create(width, height))
+	{
+		SDL_Log("Failed to create light grid.");
+		return false;
+	}
+	mGGlobalShader->SetActive();
+	mGGlobalShader->SetIntUniform("uTilesX", mLightGrid->GetNumTilesX());
+
+	for (int i = 0; i < NumPackets; i++)
+	{
+		mPackets[i] = new RenderPacket();
+	}
+	// Everything above was made with the main context, on this
+	// thread, before it moves to the render thread
+	if (mGame->UseRenderThread())
+	{
+		StartRenderThread();
+	}
 
 	return true;
 }
 
 void Renderer::Shutdown()
 {
+	StopRenderThread();
 	// Get rid of any render target textures, if they exist
 	if (mMirrorTexture != nullptr)
 	{
@@ -131,22 +232,60 @@ void Renderer::Shutdown()
 		mGBuffer->Destroy();
 		delete mGBuffer;
 	}
+	if (mLightGrid != nullptr)
+	{
+		mLightGrid->Destroy();
+		delete mLightGrid;
+	}
 	// Delete point lights
 	while (!mPointLights.empty())
 	{
 		delete mPointLights.back();
 	}
+	if (mHeadless)
+	{
+		return;
+	}
 	delete mSpriteVerts;
+	if (mSpriteBatch != nullptr)
+	{
+		mSpriteBatch->Destroy();
+		delete mSpriteBatch;
+	}
+	if (mAtlas != nullptr)
+	{
+		mAtlas->Unload();
+		delete mAtlas;
+	}
+	delete mAssetLoader;
+	for (int i = 0; i < NumPackets; i++)
+	{
+		delete mPackets[i];
+	}
 	mSpriteShader->Unload();
 	delete mSpriteShader;
 	mMeshShader->Unload();
 	delete mMeshShader;
+	mMeshInstancedShader->Unload();
+	delete mMeshInstancedShader;
+	glDeleteBuffers(1, &mFrameDataBuffer);
+	delete mRenderQueue;
 	SDL_GL_DeleteContext(mContext);
 	SDL_DestroyWindow(mWindow);
 }
 
 void Renderer::UnloadData()
 {
+	// Everything is deleted from this thread, with the main context,
+	// so the render thread has to finish first
+	StopRenderThread();
+
+	// Don't delete anything still streaming in
+	if (mAssetLoader != nullptr)
+	{
+		mAssetLoader->FinishAll();
+	}
+
 	// Destroy textures
 	for (auto i : mTextures)
 	{
@@ -166,68 +305,231 @@ void Renderer::UnloadData()
 
 void Renderer::Draw()
 {
+	PROFILE_SCOPE("Renderer::Draw");
+	if (mHeadless)
+	{
+		return;
+	}
+
+	// Create GL objects for anything that finished streaming in
+	mAssetLoader->Update(AssetUploadBudgetMS);
+
+	// Wait for the render thread to be done with the packet we
+	// built two frames ago (this only blocks if GL is the bottleneck)
+	RenderPacket* packet = mPackets[mNextPacket];
+	{
+		PROFILE_SCOPE("Renderer::WaitForPacket");
+		std::unique_lock<std::mutex> lock(mPacketMutex);
+		mPacketCondition.wait(lock, [packet]() { return !packet->mInUse; });
+	}
+	BuildPacket(*packet);
+
+	if (!mRenderThread.joinable())
+	{
+		Submit(*packet);
+		return;
+	}
+
+	// Anything this thread created (streamed in textures, new glyphs)
+	// has to be finished before the render thread draws with it
+	packet->mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	{
+		std::lock_guard<std::mutex> lock(mPacketMutex);
+		packet->mInUse = true;
+		mQueuedPackets.emplace_back(packet);
+	}
+	mPacketCondition.notify_all();
+	mNextPacket = (mNextPacket + 1) % NumPackets;
+}
+
+void Renderer::BuildPacket(RenderPacket& packet)
+{
+	PROFILE_SCOPE("Renderer::BuildPacket");
+	packet.Clear();
+	packet.mView = mRenderView;
+	packet.mMirrorView = mMirrorView;
+	packet.mProjection = mProjection;
+	packet.mAmbientLight = mAmbientLight;
+	packet.mDirLight = mDirLight;
+
+	// Only draw what's inside the view frustum
+	Frustum frustum(mRenderView * mProjection);
+	CullMeshes(frustum);
+	for (auto mc : mVisibleMeshComps)
+	{
+		mc->QueueDraw(&packet, mMeshShader, mRenderView);
+	}
+	for (auto sk : mVisibleSkeletalMeshes)
+	{
+		sk->QueueDraw(&packet, mSkinnedShader, mRenderView);
+	}
+
+	// Bin the point lights whose volumes are in view into tiles
+	CullLights(frustum);
+	mLightGrid->Update(mVisiblePointLights, mRenderView, mProjection,
+		mGame->GetJobSystem(), packet.mLights);
+
+	// Sort the sprites by draw order, if they've changed
+	if (mSpritesNeedSort)
+	{
+		std::stable_sort(mSprites.begin(), mSprites.end(),
+			[](SpriteComponent* a, SpriteComponent* b) {
+				return a->GetDrawOrder() < b->GetDrawOrder();
+		});
+		for (size_t i = 0; i < mSprites.size(); i++)
+		{
+			mSprites[i]->SetSystemIndex(static_cast<int>(i));
+		}
+		mSpritesNeedSort = false;
+	}
+	// Collect the quads for every sprite, then any UI screens
+	mSpriteBatch->Begin(&packet.mSprites);
+	for (auto sprite : mSprites)
+	{
+		if (sprite->GetVisible())
+		{
+			sprite->Draw(mSpriteBatch);
+		}
+	}
+	for (auto ui : mGame->GetUIStack())
+	{
+		ui->Draw(mSpriteBatch);
+	}
+}
+
+void Renderer::Submit(RenderPacket& packet)
+{
+	PROFILE_SCOPE("Renderer::Submit");
+	if (packet.mFence)
+	{
+		glWaitSync(packet.mFence, 0, GL_TIMEOUT_IGNORED);
+		glDeleteSync(packet.mFence);
+		packet.mFence = nullptr;
+	}
+
+	// Upload the camera and lighting data for every view
+	UpdateFrameData(packet);
+
 	// Draw to the mirror texture first
-	//Draw3DScene(mMirrorBuffer, mMirrorView, mProjection);
+	//Draw3DScene(packet, mMirrorBuffer, EMirrorView);
 	// Draw the 3D scene to the G-buffer
-	Draw3DScene(mGBuffer->GetBufferID(), mView, mProjection, false);
+	Draw3DScene(packet, mGBuffer->GetBufferID(), EMainView);
 	// Set the frame buffer back to zero (screen's frame buffer)
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	// Draw from the GBuffer
-	DrawFromGBuffer();
+	DrawFromGBuffer(packet);
 	
 	// Draw all sprite components
+	PROFILE_SCOPE("Renderer::DrawSprites");
 	// Disable depth buffering
 	glDisable(GL_DEPTH_TEST);
 	// Enable alpha blending on the color buffer
 	glEnable(GL_BLEND);
 	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
 	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
-
-	// Set shader/vao as active
+	// Draw the sprite and UI quads with the sprite shader
 	mSpriteShader->SetActive();
-	mSpriteVerts->SetActive();
-	for (auto sprite : mSprites)
+	mSpriteBatch->Submit(packet.mSprites);
+
+	// Swap the buffers
+	SDL_GL_SwapWindow(mWindow);
+}
+
+void Renderer::StartRenderThread()
+{
+	// Creating the loading context makes it current on this thread,
+	// which leaves the main context free for the render thread
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+	mLoadContext = SDL_GL_CreateContext(mWindow);
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+	if (!mLoadContext)
 	{
-		if (sprite->GetVisible())
-		{
-			sprite->Draw(mSpriteShader);
-		}
+		SDL_Log("Failed to create loading context, so no render thread: %s",
+			SDL_GetError());
+		SDL_GL_MakeCurrent(mWindow, mContext);
+		return;
 	}
-	
-	// Draw any UI screens
-	for (auto ui : mGame->GetUIStack())
+
+	mStopRenderThread = false;
+	mRenderThread = std::thread(&Renderer::RenderThreadLoop, this);
+}
+
+void Renderer::StopRenderThread()
+{
+	if (!mRenderThread.joinable())
 	{
-		ui->Draw(mSpriteShader);
+		return;
 	}
+	// It finishes drawing anything queued first
+	{
+		std::lock_guard<std::mutex> lock(mPacketMutex);
+		mStopRenderThread = true;
+	}
+	mPacketCondition.notify_all();
+	mRenderThread.join();
 
-	// Swap the buffers
-	SDL_GL_SwapWindow(mWindow);
+	// Back to just the main context, on this thread
+	SDL_GL_MakeCurrent(mWindow, mContext);
+	SDL_GL_DeleteContext(mLoadContext);
+	mLoadContext = nullptr;
 }
 
-void Renderer::AddSprite(SpriteComponent* sprite)
+void Renderer::RenderThreadLoop()
 {
-	// Find the insertion point in the sorted vector
-	// (The first element with a higher draw order than me)
-	int myDrawOrder = sprite->GetDrawOrder();
-	auto iter = mSprites.begin();
-	for (;
-		iter != mSprites.end();
-		++iter)
+	Profiler::SetThreadName("Render thread");
+	SDL_GL_MakeCurrent(mWindow, mContext);
+	while (true)
 	{
-		if (myDrawOrder < (*iter)->GetDrawOrder())
+		RenderPacket* packet = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mPacketMutex);
+			mPacketCondition.wait(lock, [this]() {
+				return !mQueuedPackets.empty() || mStopRenderThread;
+			});
+			if (mQueuedPackets.empty())
+			{
+				break;
+			}
+			packet = mQueuedPackets.front();
+			mQueuedPackets.pop_front();
+		}
+
+		Submit(*packet);
+
+		// The game thread can build in it again
 		{
-			break;
+			std::lock_guard<std::mutex> lock(mPacketMutex);
+			packet->mInUse = false;
 		}
+		mPacketCondition.notify_all();
 	}
+	// Let the game thread have the context back
+	SDL_GL_MakeCurrent(mWindow, nullptr);
+}
 
-	// Inserts element before position of iterator
-	mSprites.insert(iter, sprite);
+void Renderer::AddSprite(SpriteComponent* sprite)
+{
+	// Add to the end, and sort by draw order before the next draw
+	sprite->SetSystemIndex(static_cast<int>(mSprites.size()));
+	mSprites.emplace_back(sprite);
+	mSpritesNeedSort = true;
 }
 
 void Renderer::RemoveSprite(SpriteComponent* sprite)
 {
-	auto iter = std::find(mSprites.begin(), mSprites.end(), sprite);
-	mSprites.erase(iter);
+	int index = sprite->GetSystemIndex();
+	if (index >= 0)
+	{
+		// Erase in place, so sprites with the same draw order stay
+		// in the order they were added (there are few sprites)
+		mSprites.erase(mSprites.begin() + index);
+		for (size_t i = index; i < mSprites.size(); i++)
+		{
+			mSprites[i]->SetSystemIndex(static_cast<int>(i));
+		}
+		sprite->SetSystemIndex(-1);
+	}
 }
 
 void Renderer::AddMeshComp(MeshComponent* mesh)
@@ -235,52 +537,103 @@ void Renderer::AddMeshComp(MeshComponent* mesh)
 	if (mesh->GetIsSkeletal())
 	{
 		SkeletalMeshComponent* sk = static_cast<SkeletalMeshComponent*>(mesh);
+		sk->SetSystemIndex(static_cast<int>(mSkeletalMeshes.size()));
 		mSkeletalMeshes.emplace_back(sk);
 	}
 	else
 	{
+		mesh->SetSystemIndex(static_cast<int>(mMeshComps.size()));
 		mMeshComps.emplace_back(mesh);
 	}
 }
 
 void Renderer::RemoveMeshComp(MeshComponent* mesh)
 {
+	int index = mesh->GetSystemIndex();
+	if (index < 0)
+	{
+		return;
+	}
+
+	// Swap the last mesh into this one's place and pop off
 	if (mesh->GetIsSkeletal())
 	{
-		SkeletalMeshComponent* sk = static_cast<SkeletalMeshComponent*>(mesh);
-		auto iter = std::find(mSkeletalMeshes.begin(), mSkeletalMeshes.end(), sk);
-		mSkeletalMeshes.erase(iter);
+		SkeletalMeshComponent* last = mSkeletalMeshes.back();
+		mSkeletalMeshes[index] = last;
+		last->SetSystemIndex(index);
+		mSkeletalMeshes.pop_back();
 	}
 	else
 	{
-		auto iter = std::find(mMeshComps.begin(), mMeshComps.end(), mesh);
-		mMeshComps.erase(iter);
+		MeshComponent* last = mMeshComps.back();
+		mMeshComps[index] = last;
+		last->SetSystemIndex(index);
+		mMeshComps.pop_back();
 	}
+	mesh->SetSystemIndex(-1);
 }
 
 void Renderer::AddPointLight(PointLightComponent * light)
 {
+	light->SetSystemIndex(static_cast<int>(mPointLights.size()));
 	mPointLights.emplace_back(light);
 }
 
 void Renderer::RemovePointLight(PointLightComponent * light)
 {
-	auto iter = std::find(mPointLights.begin(), mPointLights.end(), light);
-	mPointLights.erase(iter);
+	int index = light->GetSystemIndex();
+	if (index >= 0)
+	{
+		// Swap the last light into this one's place and pop off
+		PointLightComponent* last = mPointLights.back();
+		mPointLights[index] = last;
+		last->SetSystemIndex(index);
+		mPointLights.pop_back();
+		light->SetSystemIndex(-1);
+	}
 }
 
-Texture* Renderer::GetTexture(const std::string& fileName)
+Texture* Renderer::GetTexture(const std::string& fileName, bool async)
 {
-	Texture* tex = nullptr;
+	// Packed textures are used from the atlas
+	Texture* tex = mAtlas ? mAtlas->GetTexture(fileName) : nullptr;
+	if (tex)
+	{
+		return tex;
+	}
 	auto iter = mTextures.find(fileName);
 	if (iter != mTextures.end())
 	{
 		tex = iter->second;
+		if (!async && mAssetLoader)
+		{
+			mAssetLoader->Finish(tex);
+		}
 	}
 	else
 	{
 		tex = new Texture();
-		if (tex->Load(fileName))
+		bool success = false;
+		Texture* placeholder = nullptr;
+		if (async && mAssetLoader && fileName != PlaceholderTexture)
+		{
+			placeholder = GetTexture(PlaceholderTexture);
+		}
+		if (mHeadless)
+		{
+			success = tex->LoadInfo(fileName);
+		}
+		else if (placeholder)
+		{
+			tex->SetPlaceholder(fileName, placeholder);
+			mAssetLoader->LoadTexture(tex, fileName);
+			success = true;
+		}
+		else
+		{
+			success = tex->Load(fileName);
+		}
+		if (success)
 		{
 			mTextures.emplace(fileName, tex);
 		}
@@ -293,18 +646,28 @@ Texture* Renderer::GetTexture(const std::string& fileName)
 	return tex;
 }
 
-Mesh* Renderer::GetMesh(const std::string & fileName)
+Mesh* Renderer::GetMesh(const std::string & fileName, bool async)
 {
 	Mesh* m = nullptr;
 	auto iter = mMeshes.find(fileName);
 	if (iter != mMeshes.end())
 	{
 		m = iter->second;
+		if (!async && mAssetLoader)
+		{
+			mAssetLoader->Finish(m);
+		}
 	}
 	else
 	{
 		m = new Mesh();
-		if (m->Load(fileName, this))
+		if (async && mAssetLoader)
+		{
+			m->SetFileName(fileName);
+			mAssetLoader->LoadMesh(m, fileName);
+			mMeshes.emplace(fileName, m);
+		}
+		else if (m->Load(fileName, this))
 		{
 			mMeshes.emplace(fileName, m);
 		}
@@ -317,8 +680,9 @@ Mesh* Renderer::GetMesh(const std::string & fileName)
 	return m;
 }
 
-void Renderer::Draw3DScene(unsigned int framebuffer, const Matrix4& view, const Matrix4& proj, bool lit)
+void Renderer::Draw3DScene(const RenderPacket& packet, unsigned int framebuffer, FrameView frameView)
 {
+	PROFILE_SCOPE("Renderer::Draw3DScene");
 	// Set the current frame buffer
 	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 	// Clear color buffer/depth buffer
@@ -330,39 +694,17 @@ void Renderer::Draw3DScene(unsigned int framebuffer, const Matrix4& view, const
 	// Enable depth buffering/disable alpha blend
 	glEnable(GL_DEPTH_TEST);
 	glDisable(GL_BLEND);
-	// Set the mesh shader active
-	mMeshShader->SetActive();
-	// Update view-projection matrix
-	mMeshShader->SetMatrixUniform("uViewProj", view * proj);
-	// Update lighting uniforms
-	if (lit)
-	{
-		SetLightUniforms(mMeshShader, view);
-	}
-	for (auto mc : mMeshComps)
-	{
-		if (mc->GetVisible())
-		{
-			mc->Draw(mMeshShader);
-		}
-	}
+	// Use this view's camera and lighting data
+	SetFrameView(frameView);
 
-	// Draw any skinned meshes now
-	mSkinnedShader->SetActive();
-	// Update view-projection matrix
-	mSkinnedShader->SetMatrixUniform("uViewProj", view * proj);
-	// Update lighting uniforms
-	if (lit)
+	// Draw the meshes that were in view, sorted
+	// so meshes sharing state are drawn together
+	mRenderQueue->Clear();
+	for (size_t i = 0; i < packet.mMeshDraws.size(); i++)
 	{
-		SetLightUniforms(mSkinnedShader, view);
-	}
-	for (auto sk : mSkeletalMeshes)
-	{
-		if (sk->GetVisible())
-		{
-			sk->Draw(mSkinnedShader);
-		}
+		mRenderQueue->Add(packet.GetDrawItem(i), packet.mMeshDraws[i].mDepth);
 	}
+	mRenderQueue->Submit();
 }
 
 bool Renderer::CreateMirrorTarget()
@@ -405,59 +747,160 @@ bool Renderer::CreateMirrorTarget()
 	return true;
 }
 
-void Renderer::DrawFromGBuffer()
+void Renderer::DrawFromGBuffer(const RenderPacket& packet)
 {
+	PROFILE_SCOPE("Renderer::DrawFromGBuffer");
+	// Upload the lights in view, binned into tiles
+	mLightGrid->Upload(packet.mLights);
+
 	// Clear the current framebuffer
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	
-	// Disable depth testing for the global lighting pass
+	// Disable depth testing for the lighting pass
 	glDisable(GL_DEPTH_TEST);
 	// Activate global G-buffer shader
 	mGGlobalShader->SetActive();
 	// Activate sprite verts quad
 	mSpriteVerts->SetActive();
-	// Set the G-buffer textures to sample
+	// Set the G-buffer textures and light tiles to sample
 	mGBuffer->SetTexturesActive();
-	// Set the lighting uniforms
-	SetLightUniforms(mGGlobalShader, mView);
-	// Draw the triangles
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+	mLightGrid->SetTexturesActive();
+	// (Lighting is in the main view's frame data, still bound
+	// from drawing to the G-buffer)
+	// Draw the triangles, which light every pixel with the
+	// directional light and the point lights in its tile
+	glDrawElements(GL_TRIANGLES, 6, mSpriteVerts->GetIndexType(), nullptr);
+}
 
-	// Copy depth buffer from G-buffer to default frame buffer
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, mGBuffer->GetBufferID());
-	int width = static_cast<int>(mScreenWidth);
-	int height = static_cast<int>(mScreenHeight);
-	glBlitFramebuffer(0, 0, width, height,
-		0, 0, width, height,
-		GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+void Renderer::CullMeshes(const Frustum& frustum)
+{
+	PROFILE_SCOPE("Renderer::CullMeshes");
+	// Static meshes test their bounding sphere first, then the
+	// world space box of their mesh if the sphere is in view
+	mVisibleMeshComps.clear();
+	mCullIndices.clear();
+	int numMeshes = 0;
+	for (size_t i = 0; i < mMeshComps.size(); i++)
+	{
+		MeshComponent* mc = mMeshComps[i];
+		Mesh* mesh = mc->GetMesh();
+		// (Meshes still streaming in aren't drawn)
+		if (mc->GetVisible() && mesh && mesh->IsLoaded())
+		{
+			const Matrix4& world = mc->GetOwner()->GetRenderTransform();
+			AddCullSphere(world.GetTranslation(),
+				mesh->GetRadius() * world.GetMaxScale(), static_cast<int>(i));
+			numMeshes++;
+		}
+	}
+	TestCullSpheres(frustum);
+	for (size_t i = 0; i < mCullIndices.size(); i++)
+	{
+		if (mCullVisible[i])
+		{
+			MeshComponent* mc = mMeshComps[mCullIndices[i]];
+			AABB box = TransformBox(mc->GetMesh()->GetBox(),
+				mc->GetOwner()->GetRenderTransform());
+			if (Intersect(frustum, box))
+			{
+				mVisibleMeshComps.emplace_back(mc);
+			}
+		}
+	}
+	mCullStats.mMeshesDrawn = static_cast<int>(mVisibleMeshComps.size());
+	mCullStats.mMeshesCulled = numMeshes - mCullStats.mMeshesDrawn;
 
-	// Enable depth test, but disable writes to depth buffer
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_FALSE);
+	// Skinned meshes just use (padded) bounding spheres
+	mVisibleSkeletalMeshes.clear();
+	mCullIndices.clear();
+	int numSkeletal = 0;
+	for (size_t i = 0; i < mSkeletalMeshes.size(); i++)
+	{
+		SkeletalMeshComponent* sk = mSkeletalMeshes[i];
+		Mesh* mesh = sk->GetMesh();
+		if (sk->GetVisible() && mesh && mesh->IsLoaded())
+		{
+			const Matrix4& world = sk->GetOwner()->GetRenderTransform();
+			AddCullSphere(world.GetTranslation(), mesh->GetRadius() *
+				world.GetMaxScale() * SkinnedBoundsScale, static_cast<int>(i));
+			numSkeletal++;
+		}
+	}
+	TestCullSpheres(frustum);
+	for (size_t i = 0; i < mCullIndices.size(); i++)
+	{
+		if (mCullVisible[i])
+		{
+			mVisibleSkeletalMeshes.emplace_back(mSkeletalMeshes[mCullIndices[i]]);
+		}
+	}
+	mCullStats.mSkeletalDrawn = static_cast<int>(mVisibleSkeletalMeshes.size());
+	mCullStats.mSkeletalCulled = numSkeletal - mCullStats.mSkeletalDrawn;
+}
 
-	// Set the point light shader and mesh as active
-	mGPointLightShader->SetActive();
-	mPointLightMesh->GetVertexArray()->SetActive();
-	// Set the view-projection matrix
-	mGPointLightShader->SetMatrixUniform("uViewProj",
-		mView * mProjection);
-	// Set the G-buffer textures for sampling
-	mGBuffer->SetTexturesActive();
+void Renderer::CullLights(const Frustum& frustum)
+{
+	PROFILE_SCOPE("Renderer::CullLights");
+	// The light volume is a sphere of the outer radius
+	// (scaled by the owner)
+	mVisiblePointLights.clear();
+	mCullIndices.clear();
+	for (size_t i = 0; i < mPointLights.size(); i++)
+	{
+		PointLightComponent* p = mPointLights[i];
+		const Matrix4& world = p->GetOwner()->GetRenderTransform();
+		AddCullSphere(world.GetTranslation(),
+			p->mOuterRadius * world.GetScale().x, static_cast<int>(i));
+	}
+	TestCullSpheres(frustum);
+	for (size_t i = 0; i < mCullIndices.size(); i++)
+	{
+		if (mCullVisible[i])
+		{
+			mVisiblePointLights.emplace_back(mPointLights[mCullIndices[i]]);
+		}
+	}
+	mCullStats.mLightsDrawn = static_cast<int>(mVisiblePointLights.size());
+	mCullStats.mLightsCulled = static_cast<int>(mPointLights.size()) -
+		mCullStats.mLightsDrawn;
+}
 
-	// The point light color should add to existing color
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE);
+void Renderer::AddCullSphere(const Vector3& center, float radius, int index)
+{
+	mCullX.emplace_back(center.x);
+	mCullY.emplace_back(center.y);
+	mCullZ.emplace_back(center.z);
+	mCullRadius.emplace_back(radius);
+	mCullIndices.emplace_back(index);
+}
 
-	// Draw the point lights
-	for (PointLightComponent* p : mPointLights)
+void Renderer::TestCullSpheres(const Frustum& frustum)
+{
+	mCullVisible.resize(mCullIndices.size());
+	if (!mCullIndices.empty())
 	{
-		p->Draw(mGPointLightShader, mPointLightMesh);
+		frustum.TestSpheres(mCullX.data(), mCullY.data(), mCullZ.data(),
+			mCullRadius.data(), mCullIndices.size(), mCullVisible.data());
 	}
+	// Clear the spheres for next time (but leave the indices and
+	// results, so the caller can go through them before adding more)
+	mCullX.clear();
+	mCullY.clear();
+	mCullZ.clear();
+	mCullRadius.clear();
 }
 
 bool Renderer::LoadShaders()
 {
+	// Cache linked programs in the user's pref path
+	char* prefPath = SDL_GetPrefPath("GameProgCpp", "Chapter14");
+	if (prefPath)
+	{
+		Shader::SetBinaryCacheDir(prefPath);
+		SDL_free(prefPath);
+	}
+
 	// Create sprite shader
 	mSpriteShader = new Shader();
 	if (!mSpriteShader->Load("Shaders/Sprite.vert", "Shaders/Sprite.frag"))
@@ -470,33 +913,56 @@ bool Renderer::LoadShaders()
 	Matrix4 spriteViewProj = Matrix4::CreateSimpleViewProj(mScreenWidth, mScreenHeight);
 	mSpriteShader->SetMatrixUniform("uViewProj", spriteViewProj);
 
+	// Shaders that read or write the G-buffer need to know its layout
+	std::vector<std::string> gbufferDefines;
+	if (mGame->UseCompactGBuffer())
+	{
+		gbufferDefines.emplace_back("COMPACT_GBUFFER");
+	}
+
 	// Create basic mesh shader
 	mMeshShader = new Shader();
-	if (!mMeshShader->Load("Shaders/Phong.vert", "Shaders/GBufferWrite.frag"))
+	if (!mMeshShader->Load("Shaders/Mesh.vert", "Shaders/GBufferWrite.frag",
+		gbufferDefines))
 	{
 		return false;
 	}
 
-	mMeshShader->SetActive();
-	// Set the view-projection matrix
+	// Set the view-projection matrix (used through the frame data)
 	mView = Matrix4::CreateLookAt(Vector3::Zero, Vector3::UnitX, Vector3::UnitZ);
+	mPrevView = mView;
+	mRenderView = mView;
 	mProjection = Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f),
 		mScreenWidth, mScreenHeight, 10.0f, 10000.0f);
-	mMeshShader->SetMatrixUniform("uViewProj", mView * mProjection);
+
+	// Create instanced version of the mesh shader
+	mMeshInstancedShader = new Shader();
+	std::vector<std::string> defines = gbufferDefines;
+	defines.emplace_back("INSTANCED");
+	if (!mMeshInstancedShader->Load("Shaders/Mesh.vert", "Shaders/GBufferWrite.frag",
+		defines))
+	{
+		return false;
+	}
 
 	// Create skinned shader
 	mSkinnedShader = new Shader();
-	if (!mSkinnedShader->Load("Shaders/Skinned.vert", "Shaders/GBufferWrite.frag"))
+	defines = gbufferDefines;
+	defines.emplace_back("SKINNED");
+	if (!mSkinnedShader->Load("Shaders/Mesh.vert", "Shaders/GBufferWrite.frag",
+		defines))
 	{
 		return false;
 	}
 
-	mSkinnedShader->SetActive();
-	mSkinnedShader->SetMatrixUniform("uViewProj", mView * mProjection);
-	
-	// Create shader for drawing from GBuffer (global lighting)
+	// Create shader for drawing from GBuffer (global lighting,
+	// plus the point lights in each tile)
 	mGGlobalShader = new Shader();
-	if (!mGGlobalShader->Load("Shaders/GBufferGlobal.vert", "Shaders/GBufferGlobal.frag"))
+	defines = gbufferDefines;
+	defines.emplace_back("TILED_LIGHTS");
+	defines.emplace_back("TILE_SIZE " + std::to_string(LightGrid::TileSize));
+	if (!mGGlobalShader->Load("Shaders/GBufferGlobal.vert", "Shaders/GBufferGlobal.frag",
+		defines))
 	{
 		return false;
 	}
@@ -505,27 +971,37 @@ bool Renderer::LoadShaders()
 	mGGlobalShader->SetIntUniform("uGDiffuse", 0);
 	mGGlobalShader->SetIntUniform("uGNormal", 1);
 	mGGlobalShader->SetIntUniform("uGWorldPos", 2);
+	mGGlobalShader->SetIntUniform("uGDepth", 2);
+	mGGlobalShader->SetIntUniform("uLights", LightGrid::ELightsUnit);
+	mGGlobalShader->SetIntUniform("uTiles", LightGrid::ETilesUnit);
+	mGGlobalShader->SetIntUniform("uLightIndices", LightGrid::ELightIndicesUnit);
 	// The view projection is just the sprite one
 	mGGlobalShader->SetMatrixUniform("uViewProj", spriteViewProj);
 	// The world transform scales to the screen and flips y
 	Matrix4 gbufferWorld = Matrix4::CreateScale(mScreenWidth, -mScreenHeight,
 												1.0f);
 	mGGlobalShader->SetMatrixUniform("uWorldTransform", gbufferWorld);
-	
-	// Create a shader for point lights from GBuffer
-	mGPointLightShader = new Shader();
-	if (!mGPointLightShader->Load("Shaders/BasicMesh.vert",
-								  "Shaders/GBufferPointLight.frag"))
+
+	// Create the uniform buffer for per frame data, with a FrameData
+	// for each view (each one must start at an aligned offset)
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	mFrameDataStride = sizeof(FrameData);
+	if (alignment > 0)
 	{
-		return false;
+		mFrameDataStride = (mFrameDataStride + alignment - 1) / alignment * alignment;
+	}
+	glGenBuffers(1, &mFrameDataBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, mFrameDataBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, mFrameDataStride * NumFrameViews, nullptr, GL_DYNAMIC_DRAW);
+	mFrameDataScratch.resize(mFrameDataStride * NumFrameViews);
+	// Every 3D shader reads it from the same binding point
+	Shader* frameShaders[] = { mMeshShader, mMeshInstancedShader,
+		mSkinnedShader, mGGlobalShader };
+	for (Shader* shader : frameShaders)
+	{
+		shader->SetUniformBlock("FrameData", FrameDataBinding);
 	}
-	// Set sampler indices
-	mGPointLightShader->SetActive();
-	mGPointLightShader->SetIntUniform("uGDiffuse", 0);
-	mGPointLightShader->SetIntUniform("uGNormal", 1);
-	mGPointLightShader->SetIntUniform("uGWorldPos", 2);
-	mGPointLightShader->SetVector2Uniform("uScreenDimensions",
-		Vector2(mScreenWidth, mScreenHeight));
 	return true;
 }
 
@@ -546,21 +1022,52 @@ void Renderer::CreateSpriteVerts()
 	mSpriteVerts = new VertexArray(vertices, 4, VertexArray::PosNormTex, indices, 6);
 }
 
-void Renderer::SetLightUniforms(Shader* shader, const Matrix4& view)
-{
-	// Camera position is from inverted view
-	Matrix4 invView = view;
-	invView.Invert();
-	shader->SetVectorUniform("uCameraPos", invView.GetTranslation());
-	// Ambient light
-	shader->SetVectorUniform("uAmbientLight", mAmbientLight);
-	// Directional light
-	shader->SetVectorUniform("uDirLight.mDirection",
-		mDirLight.mDirection);
-	shader->SetVectorUniform("uDirLight.mDiffuseColor",
-		mDirLight.mDiffuseColor);
-	shader->SetVectorUniform("uDirLight.mSpecColor",
-		mDirLight.mSpecColor);
+void Renderer::UpdateFrameData(const RenderPacket& packet)
+{
+	const Matrix4* views[NumFrameViews];
+	views[EMainView] = &packet.mView;
+	views[EMirrorView] = &packet.mMirrorView;
+	for (int i = 0; i < NumFrameViews; i++)
+	{
+		FrameData data = {};
+		data.mViewProj = *views[i] * packet.mProjection;
+		data.mInvViewProj = data.mViewProj;
+		data.mInvViewProj.Invert();
+		// Camera position is from inverted view
+		Matrix4 invView = *views[i];
+		invView.Invert();
+		data.mCameraPos = invView.GetTranslation();
+		data.mAmbientLight = packet.mAmbientLight;
+		data.mDirDirection = packet.mDirLight.mDirection;
+		data.mDirDiffuseColor = packet.mDirLight.mDiffuseColor;
+		data.mDirSpecColor = packet.mDirLight.mSpecColor;
+		memcpy(&mFrameDataScratch[i * mFrameDataStride], &data, sizeof(FrameData));
+	}
+
+	// Upload all the views at once
+	glBindBuffer(GL_UNIFORM_BUFFER, mFrameDataBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, mFrameDataScratch.size(),
+		mFrameDataScratch.data(), GL_DYNAMIC_DRAW);
+}
+
+void Renderer::SetFrameView(FrameView frameView)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, FrameDataBinding, mFrameDataBuffer,
+		frameView * mFrameDataStride, sizeof(FrameData));
+}
+
+void Renderer::ComputeRenderView(float alpha)
+{
+	// Camera motion over a single tick is small, so blending the
+	// matrices component-wise is a close enough approximation
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			mRenderView.mat[i][j] = Math::Lerp(mPrevView.mat[i][j],
+				mView.mat[i][j], alpha);
+		}
+	}
 }
 
 Vector3 Renderer::Unproject(const Vector3& screenPoint) const
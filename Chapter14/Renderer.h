@@ -10,6 +10,10 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <SDL/SDL.h>
 #include "Math.h"
 
@@ -26,13 +30,27 @@ struct DirectionalLight
 class Renderer
 {
 public:
+	// How many objects were drawn or culled in the last frame
+	struct CullStats
+	{
+		int mMeshesDrawn;
+		int mMeshesCulled;
+		int mSkeletalDrawn;
+		int mSkeletalCulled;
+		int mLightsDrawn;
+		int mLightsCulled;
+	};
+
 	Renderer(class Game* game);
 	~Renderer();
 
 	bool Initialize(float screenWidth, float screenHeight);
 	void Shutdown();
+	// (Stops the render thread, if it's running)
 	void UnloadData();
 
+	// Copy everything visible into a render packet, and draw it on
+	// the render thread (or right away, if there isn't one)
 	void Draw();
 
 	void AddSprite(class SpriteComponent* sprite);
@@ -44,10 +62,19 @@ public:
 	void AddPointLight(class PointLightComponent* light);
 	void RemovePointLight(class PointLightComponent* light);
 
-	class Texture* GetTexture(const std::string& fileName);
-	class Mesh* GetMesh(const std::string& fileName);
+	// If async, the asset streams in over the next few frames, and
+	// meanwhile the texture shows the default texture, and the mesh
+	// has no vertex array (so it isn't drawn). Asking for a streaming
+	// asset without async waits for it to finish
+	class Texture* GetTexture(const std::string& fileName, bool async = false);
+	class Mesh* GetMesh(const std::string& fileName, bool async = false);
 
 	void SetViewMatrix(const Matrix4& view) { mView = view; }
+	// Save the current view as the previous simulation state
+	void SaveViewHistory() { mPrevView = mView; }
+	// Compute the view to draw with, interpolated by alpha
+	// between the previous and current simulation state
+	void ComputeRenderView(float alpha);
 
 	const Vector3& GetAmbientLight() const { return mAmbientLight; }
 	void SetAmbientLight(const Vector3& ambient) { mAmbientLight = ambient; }
@@ -65,30 +92,99 @@ public:
 	// Gets start point and direction of screen vector
 	void GetScreenDirection(Vector3& outStart, Vector3& outDir) const;
 
+	const CullStats& GetCullStats() const { return mCullStats; }
+	// State changes made by the last mesh submission
+	const class RenderQueue* GetRenderQueue() const { return mRenderQueue; }
+	// Draws made by the last sprite/UI batch
+	// (both are updated by the render thread, if there is one)
+	const class SpriteBatch* GetSpriteBatch() const { return mSpriteBatch; }
+
 	float GetScreenWidth() const { return mScreenWidth; }
 	float GetScreenHeight() const { return mScreenHeight; }
 
+	// In headless mode there's no window or GL context, so
+	// nothing is drawn and assets don't create GPU resources
+	bool IsHeadless() const { return mHeadless; }
+
 	void SetMirrorView(const Matrix4& view) { mMirrorView = view; }
 	class Texture* GetMirrorTexture() { return mMirrorTexture; }
 	class GBuffer* GetGBuffer() { return mGBuffer; }
 private:
+	// Views that have per frame data
+	enum FrameView
+	{
+		EMainView,
+		EMirrorView,
+		NumFrameViews
+	};
+
+	// Per frame data for a view, laid out to match the std140
+	// FrameData uniform block in the 3D shaders
+	struct FrameData
+	{
+		Matrix4 mViewProj;
+		Matrix4 mInvViewProj;
+		Vector3 mCameraPos;
+		float mPad0;
+		Vector3 mAmbientLight;
+		float mPad1;
+		Vector3 mDirDirection;
+		float mPad2;
+		Vector3 mDirDiffuseColor;
+		float mPad3;
+		Vector3 mDirSpecColor;
+		float mPad4;
+	};
+	// Uniform buffer binding point for FrameData
+	static const unsigned int FrameDataBinding = 0;
+	// Packets that can be in flight at once (one being built while
+	// the render thread draws the other)
+	static const int NumPackets = 2;
+
+	// Fill in a packet with the current frame (game thread)
+	void BuildPacket(struct RenderPacket& packet);
+	// Draw a packet (render thread, or game thread without one)
+	void Submit(struct RenderPacket& packet);
+	// Move the main GL context to a new render thread, and keep
+	// a shared context on this thread for loading assets
+	void StartRenderThread();
+	void StopRenderThread();
+	void RenderThreadLoop();
+
 	// Chapter 14 additions
-	void Draw3DScene(unsigned int framebuffer, const Matrix4& view, const Matrix4& proj, bool lit = true);
+	void Draw3DScene(const struct RenderPacket& packet, unsigned int framebuffer,
+		FrameView frameView = EMainView);
 	bool CreateMirrorTarget();
-	void DrawFromGBuffer();
+	void DrawFromGBuffer(const struct RenderPacket& packet);
 	//void DrawFromGBuffer();
 	// End chapter 14 additions
 	bool LoadShaders();
 	void CreateSpriteVerts();
-	void SetLightUniforms(class Shader* shader, const Matrix4& view);
+	// Upload the FrameData for every view
+	void UpdateFrameData(const struct RenderPacket& packet);
+	// Bind the FrameData shaders use to this view's
+	void SetFrameView(FrameView frameView);
+	// Fill in the visible mesh/light lists for this frustum
+	void CullMeshes(const struct Frustum& frustum);
+	void CullLights(const struct Frustum& frustum);
+	// Add a bounding sphere to test, for the component at index
+	void AddCullSphere(const Vector3& center, float radius, int index);
+	// Test all added spheres (fills in mCullVisible)
+	void TestCullSpheres(const struct Frustum& frustum);
 
 	// Map of textures loaded
 	std::unordered_map<std::string, class Texture*> mTextures;
+	// Small UI/HUD textures, packed into shared textures
+	class TextureAtlas* mAtlas;
 	// Map of meshes loaded
 	std::unordered_map<std::string, class Mesh*> mMeshes;
+	// Streams in textures/meshes requested with async
+	class AssetLoader* mAssetLoader;
 
 	// All the sprite components drawn
 	std::vector<class SpriteComponent*> mSprites;
+	// Whether mSprites needs sorting by draw order
+	bool mSpritesNeedSort;
 
 	// All (non-skeletal) mesh components drawn
 	std::vector<class MeshComponent*> mMeshComps;
@@ -99,17 +195,25 @@ private:
 
 	// Sprite shader
 	class Shader* mSpriteShader;
-	// Sprite vertex array
+	// Sprite vertex array (the full screen quad for lighting)
 	class VertexArray* mSpriteVerts;
+	// Batches every sprite and UI quad into a few draws
+	class SpriteBatch* mSpriteBatch;
 
 	// Mesh shader
 	class Shader* mMeshShader;
+	// Mesh shader, for instanced draws
+	class Shader* mMeshInstancedShader;
 	// Skinned shader
 	class Shader* mSkinnedShader;
 
 	// View/projection for 3D shaders
 	Matrix4 mView;
 	Matrix4 mProjection;
+	// View at the start of the last simulation tick
+	Matrix4 mPrevView;
+	// Interpolated view used for drawing
+	Matrix4 mRenderView;
 
 	// Lighting data
 	Vector3 mAmbientLight;
@@ -117,7 +221,8 @@ private:
 
 	// Window
 	SDL_Window* mWindow;
-	// OpenGL context
+	bool mHeadless;
+	// OpenGL context (current on the render thread, if there is one)
 	SDL_GLContext mContext;
 	// Width/height
 	float mScreenWidth;
@@ -130,7 +235,45 @@ private:
 	class GBuffer* mGBuffer;
 	// GBuffer shader
 	class Shader* mGGlobalShader;
-	class Shader* mGPointLightShader;
 	std::vector<class PointLightComponent*> mPointLights;
-	class Mesh* mPointLightMesh;
+	// Point lights binned into screen tiles
+	class LightGrid* mLightGrid;
+
+	// Everything that survived culling this frame
+	std::vector<class MeshComponent*> mVisibleMeshComps;
+	std::vector<class SkeletalMeshComponent*> mVisibleSkeletalMeshes;
+	std::vector<class PointLightComponent*> mVisiblePointLights;
+	CullStats mCullStats;
+	// Bounding spheres waiting to be tested, as a structure of arrays,
+	// along with the index of the component each one is for
+	std::vector<float> mCullX;
+	std::vector<float> mCullY;
+	std::vector<float> mCullZ;
+	std::vector<float> mCullRadius;
+	std::vector<int> mCullIndices;
+	std::vector<uint8_t> mCullVisible;
+	// Sorts mesh draws to avoid redundant state changes,
+	// and instances runs of the same mesh
+	class RenderQueue* mRenderQueue;
+
+	// Uniform buffer with a FrameData for each view
+	unsigned int mFrameDataBuffer;
+	// Bytes between views in the buffer
+	size_t mFrameDataStride;
+	std::vector<uint8_t> mFrameDataScratch;
+
+	// Render thread
+	// Context assets are created with on the game thread while
+	// there's a render thread (shares objects with mContext)
+	SDL_GLContext mLoadContext;
+	// Frames for the render thread to draw, and what they're drawn from
+	struct RenderPacket* mPackets[NumPackets];
+	// Packet the next frame is built in
+	int mNextPacket;
+	std::deque<struct RenderPacket*> mQueuedPackets;
+	std::thread mRenderThread;
+	// Guards mQueuedPackets, packets' mInUse and mStopRenderThread
+	std::mutex mPacketMutex;
+	std::condition_variable mPacketCondition;
+	bool mStopRenderThread;
 };
@@ -10,7 +10,64 @@
 #include "Texture.h"
 #include <SDL/SDL.h>
 #include <fstream>
-#include <sstream>
+#include <cstring>
+
+namespace
+{
+	// Start of every cached program binary file
+	const uint32_t BinarySignature = 0x42535047; // 'GPSB'
+
+	struct BinaryHeader
+	{
+		uint32_t mSignature;
+		GLenum mFormat;
+		uint32_t mLength;
+	};
+
+	const uint64_t FNVOffset64 = 14695981039346656037ull;
+
+	// FNV-1a, continuing on from hash
+	uint64_t HashString(const std::string& str, uint64_t hash)
+	{
+		for (char c : str)
+		{
+			hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// Identifies the driver, since binaries only work with the one
+	// that made them
+	std::string GetDriverString()
+	{
+		std::string driver;
+		const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		for (GLenum name : names)
+		{
+			const GLubyte* str = glGetString(name);
+			if (str)
+			{
+				driver += reinterpret_cast<const char*>(str);
+			}
+			driver += '\n';
+		}
+		return driver;
+	}
+
+	bool IsBinaryCacheSupported()
+	{
+		if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+		{
+			return false;
+		}
+		// (Some drivers support the calls, but no formats)
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		return numFormats > 0;
+	}
+}
+
+std::string Shader::sBinaryCacheDir;
 
 Shader::Shader()
 	: mShaderProgram(0)
@@ -25,13 +82,43 @@ Shader::~Shader()
 
 }
 
-bool Shader::Load(const std::string& vertName, const std::string& fragName)
+bool Shader::Load(const std::string& vertName, const std::string& fragName,
+	const std::vector<std::string>& defines)
 {
+	std::string vertSource;
+	std::string fragSource;
+	if (!ReadSource(vertName, defines, vertSource) ||
+		!ReadSource(fragName, defines, fragSource))
+	{
+		return false;
+	}
+
+	// Use a cached binary if there's one for exactly this source
+	// and driver (otherwise it might not match, or not load)
+	std::string binaryName;
+	if (!sBinaryCacheDir.empty() && IsBinaryCacheSupported())
+	{
+		uint64_t hash = HashString(vertSource, FNVOffset64);
+		hash = HashString(fragSource, hash);
+		hash = HashString(GetDriverString(), hash);
+		char hashText[32];
+		SDL_snprintf(hashText, sizeof(hashText), "%016llx",
+			static_cast<unsigned long long>(hash));
+		binaryName = sBinaryCacheDir + hashText + ".glbin";
+		if (LoadBinary(binaryName))
+		{
+			CacheUniformLocations();
+			return true;
+		}
+	}
+
 	// Compile vertex and pixel shaders
 	if (!CompileShader(vertName,
+					   vertSource,
 					   GL_VERTEX_SHADER,
 					   mVertexShader) ||
 		!CompileShader(fragName,
+					   fragSource,
 					   GL_FRAGMENT_SHADER,
 					   mFragShader))
 	{
@@ -43,6 +130,10 @@ bool Shader::Load(const std::string& vertName, const std::string& fragName)
 	mShaderProgram = glCreateProgram();
 	glAttachShader(mShaderProgram, mVertexShader);
 	glAttachShader(mShaderProgram, mFragShader);
+	if (!binaryName.empty())
+	{
+		glProgramParameteri(mShaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glLinkProgram(mShaderProgram);
 	
 	// Verify that the program linked successfully
@@ -50,7 +141,156 @@ bool Shader::Load(const std::string& vertName, const std::string& fragName)
 	{
 		return false;
 	}
-	
+
+	if (!binaryName.empty())
+	{
+		SaveBinary(binaryName);
+	}
+	CacheUniformLocations();
+	return true;
+}
+
+bool Shader::ReadSource(const std::string& fileName,
+	const std::vector<std::string>& defines, std::string& outSource)
+{
+	std::ifstream shaderFile(fileName, std::ios::binary | std::ios::ate);
+	if (!shaderFile.is_open())
+	{
+		SDL_Log("Shader file not found: %s", fileName.c_str());
+		return false;
+	}
+	std::string contents(static_cast<size_t>(shaderFile.tellg()), '\0');
+	shaderFile.seekg(0);
+	shaderFile.read(&contents[0], contents.size());
+
+	// #version has to come first, so the defines go after it
+	size_t insertAt = 0;
+	size_t version = contents.find("#version");
+	if (version != std::string::npos)
+	{
+		insertAt = contents.find('\n', version);
+		insertAt = (insertAt == std::string::npos) ? contents.size() : insertAt + 1;
+	}
+	std::string defineText;
+	for (const auto& define : defines)
+	{
+		defineText += "#define " + define + "\n";
+	}
+	outSource = contents.substr(0, insertAt) + defineText + contents.substr(insertAt);
+	return true;
+}
+
+bool Shader::LoadBinary(const std::string& fileName)
+{
+	std::ifstream binaryFile(fileName, std::ios::binary);
+	if (!binaryFile.is_open())
+	{
+		return false;
+	}
+	BinaryHeader header;
+	if (!binaryFile.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		header.mSignature != BinarySignature)
+	{
+		return false;
+	}
+	std::vector<char> data(header.mLength);
+	if (!binaryFile.read(data.data(), data.size()))
+	{
+		return false;
+	}
+
+	mShaderProgram = glCreateProgram();
+	glProgramBinary(mShaderProgram, header.mFormat, data.data(),
+		static_cast<GLsizei>(data.size()));
+	// The driver can reject binaries (if it was updated, for example),
+	// in which case just compile like normal
+	GLint status;
+	glGetProgramiv(mShaderProgram, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		glDeleteProgram(mShaderProgram);
+		mShaderProgram = 0;
+		return false;
+	}
+	return true;
+}
+
+void Shader::SaveBinary(const std::string& fileName)
+{
+	GLint length = 0;
+	glGetProgramiv(mShaderProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return;
+	}
+	std::vector<char> data(length);
+	BinaryHeader header;
+	header.mSignature = BinarySignature;
+	glGetProgramBinary(mShaderProgram, length, nullptr, &header.mFormat, data.data());
+	header.mLength = static_cast<uint32_t>(length);
+
+	std::ofstream binaryFile(fileName, std::ios::binary);
+	if (!binaryFile.is_open())
+	{
+		SDL_Log("Failed to write shader binary %s", fileName.c_str());
+		return;
+	}
+	binaryFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	binaryFile.write(data.data(), data.size());
+}
+
+void Shader::CacheUniformLocations()
+{
+	mUniformLocations.clear();
+	GLint numUniforms = 0;
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORMS, &numUniforms);
+	char name[256];
+	for (GLint i = 0; i < numUniforms; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(mShaderProgram, i, sizeof(name), &length,
+			&size, &type, name);
+		GLint loc = glGetUniformLocation(mShaderProgram, name);
+		// (Uniforms in blocks don't have a location)
+		if (loc < 0)
+		{
+			continue;
+		}
+		// Arrays are named "uName[0]", but are set with "uName"
+		if (length > 3 && strcmp(name + length - 3, "[0]") == 0)
+		{
+			name[length - 3] = '\0';
+		}
+
+		uint32_t hash = HashName(name);
+		if (mUniformLocations.find(hash) != mUniformLocations.end())
+		{
+			SDL_Log("Uniform %s has the same hash as another uniform", name);
+		}
+		mUniformLocations[hash] = loc;
+	}
+}
+
+GLint Shader::GetUniformLocation(uint32_t nameHash) const
+{
+	auto iter = mUniformLocations.find(nameHash);
+	if (iter != mUniformLocations.end())
+	{
+		return iter->second;
+	}
+	return -1;
+}
+
+bool Shader::SetUniformBlock(const char* name, unsigned int binding)
+{
+	GLuint index = glGetUniformBlockIndex(mShaderProgram, name);
+	if (index == GL_INVALID_INDEX)
+	{
+		return false;
+	}
+	glUniformBlockBinding(mShaderProgram, index, binding);
 	return true;
 }
 
@@ -69,77 +309,84 @@ void Shader::SetActive()
 }
 
 void Shader::SetMatrixUniform(const char* name, const Matrix4& matrix)
+{
+	SetMatrixUniform(HashName(name), matrix);
+}
+
+void Shader::SetMatrixUniform(uint32_t nameHash, const Matrix4& matrix)
 {
 	// Find the uniform by this name
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
+	GLint loc = GetUniformLocation(nameHash);
 	// Send the matrix data to the uniform
 	glUniformMatrix4fv(loc, 1, GL_TRUE, matrix.GetAsFloatPtr());
 }
 
-void Shader::SetMatrixUniforms(const char* name, Matrix4* matrices, unsigned count)
+void Shader::SetMatrixUniforms(const char* name, const Matrix4* matrices, unsigned count)
+{
+	SetMatrixUniforms(HashName(name), matrices, count);
+}
+
+void Shader::SetMatrixUniforms(uint32_t nameHash, const Matrix4* matrices, unsigned count)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
+	GLint loc = GetUniformLocation(nameHash);
 	// Send the matrix data to the uniform
 	glUniformMatrix4fv(loc, count, GL_TRUE, matrices->GetAsFloatPtr());
 }
 
 void Shader::SetVectorUniform(const char* name, const Vector3& vector)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
+	SetVectorUniform(HashName(name), vector);
+}
+
+void Shader::SetVectorUniform(uint32_t nameHash, const Vector3& vector)
+{
+	GLint loc = GetUniformLocation(nameHash);
 	// Send the vector data
 	glUniform3fv(loc, 1, vector.GetAsFloatPtr());
 }
 
 void Shader::SetVector2Uniform(const char* name, const Vector2& vector)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
+	GLint loc = GetUniformLocation(HashName(name));
 	// Send the vector data
 	glUniform2fv(loc, 1, vector.GetAsFloatPtr());
 }
 
 void Shader::SetFloatUniform(const char* name, float value)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
+	SetFloatUniform(HashName(name), value);
+}
+
+void Shader::SetFloatUniform(uint32_t nameHash, float value)
+{
+	GLint loc = GetUniformLocation(nameHash);
 	// Send the float data
 	glUniform1f(loc, value);
 }
 
 void Shader::SetIntUniform(const char* name, int value)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
+	GLint loc = GetUniformLocation(HashName(name));
 	// Send the float data
 	glUniform1i(loc, value);
 }
 
 bool Shader::CompileShader(const std::string& fileName,
+				   const std::string& source,
 				   GLenum shaderType,
 				   GLuint& outShader)
 {
-	// Open file
-	std::ifstream shaderFile(fileName);
-	if (shaderFile.is_open())
-	{
-		// Read all of the text into a string
-		std::stringstream sstream;
-		sstream << shaderFile.rdbuf();
-		std::string contents = sstream.str();
-		const char* contentsChar = contents.c_str();
-		
-		// Create a shader of the specified type
-		outShader = glCreateShader(shaderType);
-		// Set the source characters and try to compile
-		glShaderSource(outShader, 1, &(contentsChar), nullptr);
-		glCompileShader(outShader);
-		
-		if (!IsCompiled(outShader))
-		{
-			SDL_Log("Failed to compile shader %s", fileName.c_str());
-			return false;
-		}
-	}
-	else
+	const char* sourceChar = source.c_str();
+	
+	// Create a shader of the specified type
+	outShader = glCreateShader(shaderType);
+	// Set the source characters and try to compile
+	glShaderSource(outShader, 1, &(sourceChar), nullptr);
+	glCompileShader(outShader);
+	
+	if (!IsCompiled(outShader))
 	{
-		SDL_Log("Shader file not found: %s", fileName.c_str());
+		SDL_Log("Failed to compile shader %s", fileName.c_str());
 		return false;
 	}
 	
@@ -9,6 +9,9 @@
 #pragma once
 #include <GL/glew.h>
 #include <string>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 #include "Math.h"
 
 class Shader
@@ -16,26 +19,63 @@ class Shader
 public:
 	Shader();
 	~Shader();
-	bool Load(const std::string& vertName, const std::string& fragName);
+	// Build a program from the vertex/fragment sources, with each
+	// of defines #defined first (so one source can have variants)
+	bool Load(const std::string& vertName, const std::string& fragName,
+		const std::vector<std::string>& defines = std::vector<std::string>());
 	void Unload();
+
+	// Save linked programs in this directory, and load them from
+	// there next time instead of compiling (empty turns it off)
+	static void SetBinaryCacheDir(const std::string& dir) { sBinaryCacheDir = dir; }
 	// Set this as the active shader program
 	void SetActive();
+	unsigned int GetProgramID() const { return mShaderProgram; }
+	// Use the uniform buffer at binding for the named block
+	// (returns false if this shader doesn't have the block)
+	bool SetUniformBlock(const char* name, unsigned int binding);
+
+	// FNV-1a hash of a uniform name. It's constexpr, so hot code
+	// can hash its names at compile time and use the overloads below
+	static constexpr uint32_t HashName(const char* name, uint32_t hash = 2166136261u)
+	{
+		return *name ? HashName(name + 1,
+			(hash ^ static_cast<uint8_t>(*name)) * 16777619u) : hash;
+	}
+	// Location of the uniform (-1 if there isn't one)
+	GLint GetUniformLocation(uint32_t nameHash) const;
+
 	// Sets a Matrix uniform
 	void SetMatrixUniform(const char* name, const Matrix4& matrix);
+	void SetMatrixUniform(uint32_t nameHash, const Matrix4& matrix);
 	// Sets an array of matrix uniforms
-	void SetMatrixUniforms(const char* name, Matrix4* matrices, unsigned count);
+	void SetMatrixUniforms(const char* name, const Matrix4* matrices, unsigned count);
+	void SetMatrixUniforms(uint32_t nameHash, const Matrix4* matrices, unsigned count);
 	// Sets a Vector3 uniform
 	void SetVectorUniform(const char* name, const Vector3& vector);
+	void SetVectorUniform(uint32_t nameHash, const Vector3& vector);
 	void SetVector2Uniform(const char* name, const Vector2& vector);
 	// Sets a float uniform
 	void SetFloatUniform(const char* name, float value);
+	void SetFloatUniform(uint32_t nameHash, float value);
 	// Sets an integer uniform
 	void SetIntUniform(const char* name, int value);
 private:
+	// Save the location of every active uniform, so setting
+	// uniforms doesn't need to ask GL
+	void CacheUniformLocations();
+	// Read the source file, adding the defines after #version
+	bool ReadSource(const std::string& fileName,
+					const std::vector<std::string>& defines,
+					std::string& outSource);
 	// Tries to compile the specified shader
 	bool CompileShader(const std::string& fileName,
+					   const std::string& source,
 					   GLenum shaderType,
 					   GLuint& outShader);
+	// Try to make the program from a cached binary
+	bool LoadBinary(const std::string& fileName);
+	void SaveBinary(const std::string& fileName);
 	
 	// Tests whether shader compiled successfully
 	bool IsCompiled(GLuint shader);
@@ -46,4 +86,8 @@ private:
 	GLuint mVertexShader;
 	GLuint mFragShader;
 	GLuint mShaderProgram;
+	// Name hash to uniform location
+	std::unordered_map<uint32_t, GLint> mUniformLocations;
+
+	static std::string sBinaryCacheDir;
 };
@@ -9,6 +9,11 @@
 // Request GLSL 3.3
 #version 330
 
+// With TILED_LIGHTS (and TILE_SIZE) defined, this also adds in
+// the point lights listed for this pixel's tile (see LightGrid).
+// With COMPACT_GBUFFER defined, it reads the compact G-buffer
+// layout (see GBuffer::Layout)
+
 // Inputs from vertex shader
 // Tex coord
 in vec2 fragTexCoord;
@@ -19,7 +24,11 @@ layout(location = 0) out vec4 outColor;
 // Different textures from G-buffer
 uniform sampler2D uGDiffuse;
 uniform sampler2D uGNormal;
+#ifdef COMPACT_GBUFFER
+uniform sampler2D uGDepth;
+#else
 uniform sampler2D uGWorldPos;
+#endif
 
 // Create a struct for directional light
 struct DirectionalLight
@@ -32,38 +41,103 @@ struct DirectionalLight
 	vec3 mSpecColor;
 };
 
-// Uniforms for lighting
-// Camera position (in world space)
-uniform vec3 uCameraPos;
-// Ambient light level
-uniform vec3 uAmbientLight;
-// Directional Light
-uniform DirectionalLight uDirLight;
+// Per frame data shared by the 3D shaders
+// (matches Renderer::FrameData, and must be the same in every shader)
+layout(std140, row_major) uniform FrameData
+{
+	// View-projection matrix
+	mat4 mViewProj;
+	// Inverse of the view-projection matrix
+	mat4 mInvViewProj;
+	// Camera position (in world space)
+	vec3 mCameraPos;
+	// Ambient light level
+	vec3 mAmbientLight;
+	// Directional light
+	DirectionalLight mDirLight;
+} uFrame;
+
+#ifdef TILED_LIGHTS
+// Point lights, two texels each: world pos + inner radius,
+// then diffuse color + outer radius
+uniform samplerBuffer uLights;
+// For each tile, offset into uLightIndices and number of lights
+uniform usamplerBuffer uTiles;
+uniform usamplerBuffer uLightIndices;
+// Number of tiles across the screen
+uniform int uTilesX;
+#endif
+
+#ifdef COMPACT_GBUFFER
+// Undo the octahedral encoding from GBufferWrite.frag
+vec3 DecodeNormal(vec2 f)
+{
+	f = f * 2.0 - 1.0;
+	vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return n;
+}
+#endif
 
 void main()
 {
 	vec3 gbufferDiffuse = texture(uGDiffuse, fragTexCoord).xyz;
+#ifdef COMPACT_GBUFFER
+	vec3 gbufferNorm = DecodeNormal(texture(uGNormal, fragTexCoord).xy);
+	// Rebuild world position from depth, by unprojecting
+	// this pixel's clip space position
+	float depth = texture(uGDepth, fragTexCoord).x;
+	vec4 clipPos = vec4(fragTexCoord * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec4 worldPos = clipPos * uFrame.mInvViewProj;
+	vec3 gbufferWorldPos = worldPos.xyz / worldPos.w;
+#else
 	vec3 gbufferNorm = texture(uGNormal, fragTexCoord).xyz;
 	vec3 gbufferWorldPos = texture(uGWorldPos, fragTexCoord).xyz;
+#endif
 	// Surface normal
 	vec3 N = normalize(gbufferNorm);
 	// Vector from surface to light
-	vec3 L = normalize(-uDirLight.mDirection);
+	vec3 L = normalize(-uFrame.mDirLight.mDirection);
 	// Vector from surface to camera
-	vec3 V = normalize(uCameraPos - gbufferWorldPos);
+	vec3 V = normalize(uFrame.mCameraPos - gbufferWorldPos);
 	// Reflection of -L about N
 	vec3 R = normalize(reflect(-L, N));
 
 	// Compute phong reflection
-	vec3 Phong = uAmbientLight;
+	vec3 Phong = uFrame.mAmbientLight;
 	float NdotL = dot(N, L);
 	if (NdotL > 0)
 	{
-		vec3 Diffuse = uDirLight.mDiffuseColor * dot(N, L);
+		vec3 Diffuse = uFrame.mDirLight.mDiffuseColor * dot(N, L);
 	}
 	// Clamp light between 0-1 RGB values
 	Phong = clamp(Phong, 0.0, 1.0);
 
+#ifdef TILED_LIGHTS
+	// Add the diffuse from every point light that reaches this tile
+	ivec2 tile = ivec2(gl_FragCoord.xy) / TILE_SIZE;
+	uvec2 tileLights = texelFetch(uTiles, tile.y * uTilesX + tile.x).xy;
+	for (uint i = 0u; i < tileLights.y; i++)
+	{
+		int light = int(texelFetch(uLightIndices, int(tileLights.x + i)).x);
+		vec4 posInner = texelFetch(uLights, light * 2);
+		vec4 colorOuter = texelFetch(uLights, light * 2 + 1);
+		// Vector from surface to light
+		vec3 PointL = normalize(posInner.xyz - gbufferWorldPos);
+		float PointNdotL = dot(N, PointL);
+		if (PointNdotL > 0)
+		{
+			// Use smoothstep to compute value in range [0,1]
+			// between inner/outer radius
+			float dist = distance(posInner.xyz, gbufferWorldPos);
+			float intensity = smoothstep(posInner.w, colorOuter.w, dist);
+			Phong += mix(colorOuter.rgb, vec3(0.0, 0.0, 0.0), intensity) * PointNdotL;
+		}
+	}
+#endif
+
 	// Final color is texture color times phong light (alpha = 1)
 	outColor = vec4(gbufferDiffuse * Phong, 1.0);
 }
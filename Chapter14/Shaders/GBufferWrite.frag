@@ -8,6 +8,11 @@
 
 // Request GLSL 3.3
 #version 330
+
+// With COMPACT_GBUFFER defined, this writes the compact layout
+// (see GBuffer::Layout), which needs the spec power too
+#define MAX_SPEC_POWER 256.0
+
 // Inputs from vertex shader
 // Tex coord
 in vec2 fragTexCoord;
@@ -16,19 +21,59 @@ in vec3 fragNormal;
 // Position (in world space)
 in vec3 fragWorldPos;
 
+#ifdef COMPACT_GBUFFER
+// Diffuse color, with spec power (over MAX_SPEC_POWER) in alpha
+layout(location = 0) out vec4 outDiffuse;
+// Octahedral encoded normal
+layout(location = 1) out vec2 outNormal;
+// (World position is rebuilt from depth)
+
+#ifdef INSTANCED
+flat in float fragSpecPower;
+#else
+uniform float uSpecPower;
+#endif
+#else
 // This corresponds to the outputs to the G-buffer
 layout(location = 0) out vec3 outDiffuse;
 layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec3 outWorldPos;
+#endif
 
 // This is used for the texture sampling
 uniform sampler2D uTexture;
 
+#ifdef COMPACT_GBUFFER
+// Map a unit vector onto the octahedron, then unfold the
+// lower half over the upper half, giving [0,1] x [0,1]
+vec2 EncodeNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	if (n.z < 0.0)
+	{
+		vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signs;
+	}
+	return n.xy * 0.5 + 0.5;
+}
+#endif
+
 void main()
 {
+#ifdef COMPACT_GBUFFER
+#ifdef INSTANCED
+	float specPower = fragSpecPower;
+#else
+	float specPower = uSpecPower;
+#endif
+	outDiffuse = vec4(texture(uTexture, fragTexCoord).xyz,
+		clamp(specPower / MAX_SPEC_POWER, 0.0, 1.0));
+	outNormal = EncodeNormal(normalize(fragNormal));
+#else
 	// Diffuse color is sampled from texture
 	outDiffuse = texture(uTexture, fragTexCoord).xyz;
 	// Normal/world pos are passed directly along
 	outNormal = fragNormal;
 	outWorldPos = fragWorldPos;
+#endif
 }
@@ -0,0 +1,124 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+// Request GLSL 3.3
+#version 330
+
+// Vertex shader for meshes, with variants picked by defines:
+// SKINNED   - skin with uMatrixPalette (PosNormSkinTex vertices)
+// INSTANCED - world transform and spec power are per instance
+
+#if defined(SKINNED) && defined(INSTANCED)
+#error Skinned meshes can't be instanced
+#endif
+
+// Create a struct for directional light
+struct DirectionalLight
+{
+	// Direction of light
+	vec3 mDirection;
+	// Diffuse color
+	vec3 mDiffuseColor;
+	// Specular color
+	vec3 mSpecColor;
+};
+
+// Per frame data shared by the 3D shaders
+// (matches Renderer::FrameData, and must be the same in every shader)
+layout(std140, row_major) uniform FrameData
+{
+	// View-projection matrix
+	mat4 mViewProj;
+	// Inverse of the view-projection matrix
+	mat4 mInvViewProj;
+	// Camera position (in world space)
+	vec3 mCameraPos;
+	// Ambient light level
+	vec3 mAmbientLight;
+	// Directional light
+	DirectionalLight mDirLight;
+} uFrame;
+
+// Attribute 0 is position, 1 is normal
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+// Packed positions are 0-1 in the mesh's bounding box, so are scaled
+// and offset back into object space (1 and 0 for float positions)
+uniform vec3 uPosScale;
+uniform vec3 uPosOffset;
+
+#ifdef SKINNED
+// Uniform for matrix palette
+uniform mat4 uMatrixPalette[96];
+// 2 is bone indices, 3 is weights, 4 is tex coords
+layout(location = 2) in uvec4 inSkinBones;
+layout(location = 3) in vec4 inSkinWeights;
+layout(location = 4) in vec2 inTexCoord;
+#else
+// 2 is tex coords
+layout(location = 2) in vec2 inTexCoord;
+#endif
+
+#ifdef INSTANCED
+// Per instance attributes: 3-6 is world transform, 7 is spec power.
+// The matrix is read in a row per attribute, so it's the transpose
+// of uWorldTransform (and multiplies on the left)
+layout(location = 3) in mat4 inWorldTransform;
+layout(location = 7) in float inSpecPower;
+// Specular power, for fragment shaders that use it
+flat out float fragSpecPower;
+#else
+// Uniform for world transform
+uniform mat4 uWorldTransform;
+#endif
+
+// Any vertex outputs (other than position)
+out vec2 fragTexCoord;
+// Normal (in world space)
+out vec3 fragNormal;
+// Position (in world space)
+out vec3 fragWorldPos;
+
+void main()
+{
+	// Convert position to homogeneous coordinates
+	vec4 pos = vec4(inPosition * uPosScale + uPosOffset, 1.0);
+	// Normal has w = 0
+	vec4 normal = vec4(inNormal, 0.0f);
+
+#ifdef SKINNED
+	// Skin the position and normal
+	pos = (pos * uMatrixPalette[inSkinBones.x]) * inSkinWeights.x
+		+ (pos * uMatrixPalette[inSkinBones.y]) * inSkinWeights.y
+		+ (pos * uMatrixPalette[inSkinBones.z]) * inSkinWeights.z
+		+ (pos * uMatrixPalette[inSkinBones.w]) * inSkinWeights.w;
+	normal = (normal * uMatrixPalette[inSkinBones.x]) * inSkinWeights.x
+		+ (normal * uMatrixPalette[inSkinBones.y]) * inSkinWeights.y
+		+ (normal * uMatrixPalette[inSkinBones.z]) * inSkinWeights.z
+		+ (normal * uMatrixPalette[inSkinBones.w]) * inSkinWeights.w;
+#endif
+
+	// Transform position and normal to world space
+#ifdef INSTANCED
+	pos = inWorldTransform * pos;
+	normal = inWorldTransform * normal;
+	fragSpecPower = inSpecPower;
+#else
+	pos = pos * uWorldTransform;
+	normal = normal * uWorldTransform;
+#endif
+
+	// Save world position
+	fragWorldPos = pos.xyz;
+	// Transform to clip space
+	gl_Position = pos * uFrame.mViewProj;
+	fragNormal = normal.xyz;
+
+	// Pass along the texture coordinate to frag shader
+	fragTexCoord = inTexCoord;
+}
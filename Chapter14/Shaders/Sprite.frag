@@ -11,6 +11,8 @@
 
 // Tex coord input from vertex shader
 in vec2 fragTexCoord;
+// Color to tint the texture by
+in vec4 fragColor;
 
 // This corresponds to the output color to the color buffer
 out vec4 outColor;
@@ -20,6 +22,6 @@ uniform sampler2D uTexture;
 
 void main()
 {
-	// Sample color from texture
-    outColor = texture(uTexture, fragTexCoord);
+	// Sample color from texture, and tint it
+    outColor = texture(uTexture, fragTexCoord) * fragColor;
 }
@@ -9,25 +9,26 @@
 // Request GLSL 3.3
 #version 330
 
-// Uniforms for world transform and view-proj
-uniform mat4 uWorldTransform;
+// Uniform for view-proj (sprite batches are already in world space)
 uniform mat4 uViewProj;
 
-// Attribute 0 is position, 1 is normal, 2 is tex coords.
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec2 inTexCoord;
+// Attribute 0 is position, 1 is tex coords, 2 is color.
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec4 inColor;
 
 // Any vertex outputs (other than position)
 out vec2 fragTexCoord;
+out vec4 fragColor;
 
 void main()
 {
 	// Convert position to homogeneous coordinates
-	vec4 pos = vec4(inPosition, 1.0);
-	// Transform to position world space, then clip space
-	gl_Position = pos * uWorldTransform * uViewProj;
+	vec4 pos = vec4(inPosition, 0.0, 1.0);
+	// Transform to clip space
+	gl_Position = pos * uViewProj;
 
-	// Pass along the texture coordinate to frag shader
+	// Pass along the texture coordinate and color to frag shader
 	fragTexCoord = inTexCoord;
+	fragColor = inColor;
 }
@@ -17,6 +17,7 @@
 #include "Animation.h"
 #include "Skeleton.h"
 #include "LevelLoader.h"
+#include "RenderPacket.h"
 
 SkeletalMeshComponent::SkeletalMeshComponent(Actor* owner)
 	:MeshComponent(owner, true)
@@ -24,29 +25,26 @@ SkeletalMeshComponent::SkeletalMeshComponent(Actor* owner)
 {
 }
 
-void SkeletalMeshComponent::Draw(Shader* shader)
+void SkeletalMeshComponent::QueueDraw(RenderPacket* packet, Shader* shader, const Matrix4& view)
 {
 	if (mMesh)
 	{
-		// Set the world transform
-		shader->SetMatrixUniform("uWorldTransform", 
-			mOwner->GetWorldTransform());
-		// Set the matrix palette
-		shader->SetMatrixUniforms("uMatrixPalette", &mPalette.mEntry[0], 
-			MAX_SKELETON_BONES);
-		// Set specular power
-		shader->SetFloatUniform("uSpecPower", mMesh->GetSpecPower());
-		// Set the active texture
-		Texture* t = mMesh->GetTexture(mTextureIndex);
-		if (t)
-		{
-			t->SetActive();
-		}
-		// Set the mesh's vertex array as active
-		VertexArray* va = mMesh->GetVertexArray();
-		va->SetActive();
-		// Draw
-		glDrawElements(GL_TRIANGLES, va->GetNumIndices(), GL_UNSIGNED_INT, nullptr);
+		RenderQueue::DrawItem item;
+		item.mShader = shader;
+		item.mVertexArray = mMesh->GetVertexArray();
+		Texture* texture = mMesh->GetTexture(mTextureIndex);
+		item.mTextureID = texture ? texture->GetTextureID() : 0;
+		item.mWorldTransform = nullptr;
+		item.mPalette = nullptr;
+		item.mPaletteSize = MAX_SKELETON_BONES;
+		item.mSpecPower = mMesh->GetSpecPower();
+		Vector3 viewPos = Vector3::Transform(
+			mOwner->GetRenderTransform().GetTranslation(), view);
+		UpdateLod(viewPos.z, packet->mProjection);
+		const Mesh::Lod& lod = mMesh->GetLod(mLod);
+		item.mFirstIndex = lod.mFirstIndex;
+		item.mNumIndices = lod.mNumIndices;
+		packet->AddMesh(item, viewPos.z, mOwner->GetRenderTransform(), &mPalette);
 	}
 }
 
@@ -14,8 +14,9 @@ class SkeletalMeshComponent : public MeshComponent
 {
 public:
 	SkeletalMeshComponent(class Actor* owner);
-	// Draw this mesh component
-	void Draw(class Shader* shader) override;
+	// Add a draw of this mesh component to the frame's packet
+	void QueueDraw(struct RenderPacket* packet, class Shader* shader,
+		const Matrix4& view) override;
 
 	void Update(float deltaTime) override;
 
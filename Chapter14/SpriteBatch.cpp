@@ -0,0 +1,192 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "SpriteBatch.h"
+#include "Texture.h"
+#include "Profiler.h"
+#include <GL/glew.h>
+#include <cstddef>
+
+namespace
+{
+	uint8_t ToByte(float value)
+	{
+		return static_cast<uint8_t>(Math::Clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+}
+
+SpriteBatch::SpriteBatch()
+	:mFrame(nullptr)
+	,mStats()
+	,mVertexArray(0)
+	,mVertexBuffer(0)
+	,mIndexBuffer(0)
+{
+}
+
+SpriteBatch::~SpriteBatch()
+{
+}
+
+bool SpriteBatch::Create()
+{
+	glGenVertexArrays(1, &mVertexArray);
+	glBindVertexArray(mVertexArray);
+
+	// Vertices are uploaded every frame
+	glGenBuffers(1, &mVertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+
+	// Every quad uses the same indices, so they never change
+	// (draws start from a base vertex instead)
+	std::vector<uint16_t> indices(MaxQuadsPerDraw * 6);
+	for (int i = 0; i < MaxQuadsPerDraw; i++)
+	{
+		uint16_t v = static_cast<uint16_t>(i * 4);
+		uint16_t* quad = &indices[i * 6];
+		quad[0] = v;
+		quad[1] = v + 1;
+		quad[2] = v + 2;
+		quad[3] = v + 2;
+		quad[4] = v + 3;
+		quad[5] = v;
+	}
+	glGenBuffers(1, &mIndexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t),
+		indices.data(), GL_STATIC_DRAW);
+
+	// Position is 2 floats
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+		reinterpret_cast<void*>(offsetof(Vertex, mPos)));
+	// Texture coordinates is 2 floats
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+		reinterpret_cast<void*>(offsetof(Vertex, mTexCoord)));
+	// Color is 4 bytes (converted to 0.0 to 1.0)
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex),
+		reinterpret_cast<void*>(offsetof(Vertex, mColor)));
+
+	glBindVertexArray(0);
+	return glGetError() == GL_NO_ERROR;
+}
+
+void SpriteBatch::Destroy()
+{
+	glDeleteBuffers(1, &mVertexBuffer);
+	glDeleteBuffers(1, &mIndexBuffer);
+	glDeleteVertexArrays(1, &mVertexArray);
+}
+
+void SpriteBatch::Begin(Frame* frame)
+{
+	mFrame = frame;
+	mFrame->mVertices.clear();
+	mFrame->mRuns.clear();
+}
+
+void SpriteBatch::Draw(Texture* texture, const Matrix4& world,
+	const Vector2& uvMin, const Vector2& uvMax,
+	const Vector3& color, float alpha)
+{
+	if (!texture)
+	{
+		return;
+	}
+
+	// Start a new run if the GL texture changes
+	// (textures from the same atlas page share one)
+	std::vector<Vertex>& vertices = mFrame->mVertices;
+	std::vector<Run>& runs = mFrame->mRuns;
+	int quad = static_cast<int>(vertices.size() / 4);
+	if (runs.empty() || runs.back().mTextureID != texture->GetTextureID())
+	{
+		Run run;
+		run.mTextureID = texture->GetTextureID();
+		run.mFirstQuad = quad;
+		run.mNumQuads = 0;
+		runs.emplace_back(run);
+	}
+	runs.back().mNumQuads++;
+
+	// Transform the corners of the unit quad, in the same order
+	// as the indices (top left, top right, bottom right, bottom left)
+	const float corners[4][2] = {
+		{ -0.5f, 0.5f }, { 0.5f, 0.5f }, { 0.5f, -0.5f }, { -0.5f, -0.5f }
+	};
+	// (UVs are within the texture, so map them to its part of the atlas)
+	Vector2 atlasMin = texture->GetUVMin();
+	Vector2 atlasSize = texture->GetUVMax() - atlasMin;
+	Vector2 min(atlasMin.x + uvMin.x * atlasSize.x, atlasMin.y + uvMin.y * atlasSize.y);
+	Vector2 max(atlasMin.x + uvMax.x * atlasSize.x, atlasMin.y + uvMax.y * atlasSize.y);
+	const float texCoords[4][2] = {
+		{ min.x, min.y }, { max.x, min.y },
+		{ max.x, max.y }, { min.x, max.y }
+	};
+	uint8_t rgba[4] = { ToByte(color.x), ToByte(color.y), ToByte(color.z), ToByte(alpha) };
+	for (int i = 0; i < 4; i++)
+	{
+		Vertex v;
+		// (Only x/y matter, since sprites don't depth test)
+		float x = corners[i][0];
+		float y = corners[i][1];
+		v.mPos[0] = x * world.mat[0][0] + y * world.mat[1][0] + world.mat[3][0];
+		v.mPos[1] = x * world.mat[0][1] + y * world.mat[1][1] + world.mat[3][1];
+		v.mTexCoord[0] = texCoords[i][0];
+		v.mTexCoord[1] = texCoords[i][1];
+		for (int c = 0; c < 4; c++)
+		{
+			v.mColor[c] = rgba[c];
+		}
+		vertices.emplace_back(v);
+	}
+}
+
+void SpriteBatch::Draw(Texture* texture, const Matrix4& world)
+{
+	Draw(texture, world, Vector2::Zero, Vector2(1.0f, 1.0f));
+}
+
+void SpriteBatch::Submit(const Frame& frame)
+{
+	PROFILE_SCOPE("SpriteBatch::Submit");
+	mStats = Stats();
+	if (frame.mVertices.empty())
+	{
+		return;
+	}
+
+	// Upload the whole frame's quads at once
+	// (orphaning last frame's buffer, so this doesn't wait on it)
+	glBindVertexArray(mVertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, frame.mVertices.size() * sizeof(Vertex),
+		frame.mVertices.data(), GL_STREAM_DRAW);
+
+	glActiveTexture(GL_TEXTURE0);
+	for (const Run& run : frame.mRuns)
+	{
+		glBindTexture(GL_TEXTURE_2D, run.mTextureID);
+		// Split runs too long for the index buffer
+		for (int first = 0; first < run.mNumQuads; first += MaxQuadsPerDraw)
+		{
+			int count = run.mNumQuads - first;
+			if (count > MaxQuadsPerDraw)
+			{
+				count = MaxQuadsPerDraw;
+			}
+			glDrawElementsBaseVertex(GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT,
+				nullptr, (run.mFirstQuad + first) * 4);
+			mStats.mDraws++;
+		}
+	}
+	mStats.mQuads = static_cast<int>(frame.mVertices.size() / 4);
+}
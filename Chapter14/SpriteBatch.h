@@ -0,0 +1,86 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Math.h"
+
+// Collects the 2D quads for a frame (sprites and UI) into one
+// streaming vertex buffer, already transformed, and draws each run
+// of quads that use the same texture with a single draw call.
+// Quads are drawn in the order they're added, so draw order holds.
+// The quads go into a Frame the caller owns, so one frame can be
+// drawn (on the GL thread) while the next one is being collected
+class SpriteBatch
+{
+public:
+	// Most quads a single draw can have (16-bit indices)
+	static const int MaxQuadsPerDraw = 16384;
+
+	// How many draws the last Submit took
+	struct Stats
+	{
+		int mDraws;
+		int mQuads;
+	};
+
+	struct Vertex
+	{
+		float mPos[2];
+		float mTexCoord[2];
+		uint8_t mColor[4];
+	};
+
+	// Quads in a row with the same GL texture
+	struct Run
+	{
+		unsigned int mTextureID;
+		int mFirstQuad;
+		int mNumQuads;
+	};
+
+	// Every quad for a frame
+	struct Frame
+	{
+		std::vector<Vertex> mVertices;
+		std::vector<Run> mRuns;
+	};
+
+	SpriteBatch();
+	~SpriteBatch();
+
+	// Create/destroy the GL buffers
+	bool Create();
+	void Destroy();
+
+	// Start adding quads to this frame (clearing it first)
+	void Begin(Frame* frame);
+	// Add a quad with the texture on it. world transforms the unit
+	// quad (centered on the origin) to the screen, and uvMin/uvMax
+	// are the corners of the texture to use (top left/bottom right,
+	// relative to the texture even if it's in an atlas)
+	void Draw(class Texture* texture, const Matrix4& world,
+		const Vector2& uvMin, const Vector2& uvMax,
+		const Vector3& color = Color::White, float alpha = 1.0f);
+	// Add a quad with the whole texture on it
+	void Draw(class Texture* texture, const Matrix4& world);
+	// Upload a frame's quads and draw them
+	// (with the sprite shader and blend state already set)
+	void Submit(const Frame& frame);
+
+	const Stats& GetStats() const { return mStats; }
+private:
+	// Frame quads are being added to
+	Frame* mFrame;
+	Stats mStats;
+
+	unsigned int mVertexArray;
+	unsigned int mVertexBuffer;
+	unsigned int mIndexBuffer;
+};
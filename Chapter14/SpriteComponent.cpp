@@ -8,7 +8,7 @@
 
 #include "SpriteComponent.h"
 #include "Texture.h"
-#include "Shader.h"
+#include "SpriteBatch.h"
 #include "Actor.h"
 #include "Game.h"
 #include "Renderer.h"
@@ -30,7 +30,19 @@ SpriteComponent::~SpriteComponent()
 	mOwner->GetGame()->GetRenderer()->RemoveSprite(this);
 }
 
-void SpriteComponent::Draw(Shader* shader)
+void SpriteComponent::OnRecycle()
+{
+	Component::OnRecycle();
+	mOwner->GetGame()->GetRenderer()->RemoveSprite(this);
+}
+
+void SpriteComponent::OnReuse()
+{
+	Component::OnReuse();
+	mOwner->GetGame()->GetRenderer()->AddSprite(this);
+}
+
+void SpriteComponent::Draw(SpriteBatch* batch)
 {
 	if (mTexture)
 	{
@@ -40,17 +52,11 @@ void SpriteComponent::Draw(Shader* shader)
 			static_cast<float>(mTexHeight),
 			1.0f);
 		
-		Matrix4 world = scaleMat * mOwner->GetWorldTransform();
-		
-		// Since all sprites use the same shader/vertices,
-		// the game first sets them active before any sprite draws
+		Matrix4 world = scaleMat * mOwner->GetRenderTransform();
 		
-		// Set world transform
-		shader->SetMatrixUniform("uWorldTransform", world);
-		// Set current texture
-		mTexture->SetActive();
-		// Draw quad
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+		// Add the quad to the batch (which draws it with
+		// any neighboring sprites that use the same texture)
+		batch->Draw(mTexture, world);
 	}
 }
 
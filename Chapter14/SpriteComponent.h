@@ -17,7 +17,10 @@ public:
 	SpriteComponent(class Actor* owner, int drawOrder = 100);
 	~SpriteComponent();
 
-	virtual void Draw(class Shader* shader);
+	void OnRecycle() override;
+	void OnReuse() override;
+
+	virtual void Draw(class SpriteBatch* batch);
 	virtual void SetTexture(class Texture* texture);
 
 	int GetDrawOrder() const { return mDrawOrder; }
@@ -13,5 +13,6 @@ class TargetActor : public Actor
 {
 public:
 	TargetActor(class Game* game);
-	TypeID GetType() const override { return TTargetActor; }
+	static const TypeID StaticType = TTargetActor;
+	TypeID GetType() const override { return StaticType; }
 };
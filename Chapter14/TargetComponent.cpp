@@ -25,3 +25,15 @@ TargetComponent::~TargetComponent()
 {
 	mOwner->GetGame()->GetHUD()->RemoveTargetComponent(this);
 }
+
+void TargetComponent::OnRecycle()
+{
+	Component::OnRecycle();
+	mOwner->GetGame()->GetHUD()->RemoveTargetComponent(this);
+}
+
+void TargetComponent::OnReuse()
+{
+	Component::OnReuse();
+	mOwner->GetGame()->GetHUD()->AddTargetComponent(this);
+}
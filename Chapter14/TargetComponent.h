@@ -14,5 +14,9 @@ class TargetComponent : public Component
 public:
 	TargetComponent(class Actor* owner);
 	~TargetComponent();
+
+	void OnRecycle() override;
+	void OnReuse() override;
+
 	TypeID GetType() const override { return TTargetComponent; }
 };
@@ -0,0 +1,121 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "TaskGraph.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include <thread>
+
+TaskGraph::TaskGraph(JobSystem* jobs)
+	:mJobs(jobs)
+	,mNumFinished(0)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+	for (auto t : mTasks)
+	{
+		delete t;
+	}
+}
+
+int TaskGraph::AddTask(const std::string& name, TaskFunc func, bool mainThread)
+{
+	Task* t = new Task();
+	t->mName = name;
+	t->mFunc = func;
+	t->mMainThread = mainThread;
+	t->mNumDependencies = 0;
+	t->mRemaining = 0;
+	mTasks.emplace_back(t);
+	return static_cast<int>(mTasks.size()) - 1;
+}
+
+void TaskGraph::AddDependency(int before, int after)
+{
+	mTasks[before]->mDependents.emplace_back(after);
+	mTasks[after]->mNumDependencies++;
+}
+
+void TaskGraph::Run()
+{
+	mNumFinished = 0;
+	for (auto t : mTasks)
+	{
+		t->mRemaining = t->mNumDependencies;
+	}
+
+	// Start everything that doesn't depend on anything
+	int numTasks = static_cast<int>(mTasks.size());
+	for (int i = 0; i < numTasks; i++)
+	{
+		if (mTasks[i]->mNumDependencies == 0)
+		{
+			Schedule(i);
+		}
+	}
+
+	// Run main thread tasks as they become ready, and help with
+	// other jobs in the meantime
+	while (mNumFinished.load() < numTasks)
+	{
+		int taskID = -1;
+		{
+			std::lock_guard<std::mutex> lock(mMainThreadMutex);
+			if (!mMainThreadReady.empty())
+			{
+				taskID = mMainThreadReady.back();
+				mMainThreadReady.pop_back();
+			}
+		}
+
+		if (taskID >= 0)
+		{
+			Execute(taskID);
+		}
+		else if (!mJobs->RunOneJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void TaskGraph::Schedule(int taskID)
+{
+	if (mTasks[taskID]->mMainThread)
+	{
+		std::lock_guard<std::mutex> lock(mMainThreadMutex);
+		mMainThreadReady.emplace_back(taskID);
+	}
+	else
+	{
+		mJobs->Run([this, taskID]() {
+			Execute(taskID);
+		});
+	}
+}
+
+void TaskGraph::Execute(int taskID)
+{
+	Task* t = mTasks[taskID];
+	{
+		PROFILE_SCOPE(t->mName.c_str());
+		t->mFunc();
+	}
+
+	// Start any dependents that were only waiting on this task
+	for (int dependent : t->mDependents)
+	{
+		if (--mTasks[dependent]->mRemaining == 0)
+		{
+			Schedule(dependent);
+		}
+	}
+	mNumFinished++;
+}
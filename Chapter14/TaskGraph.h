@@ -0,0 +1,59 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <string>
+#include <functional>
+#include <mutex>
+#include <atomic>
+
+// A set of tasks with dependencies between them. Once built, the
+// graph can be run any number of times (say, once per frame), and
+// tasks that don't depend on each other run at the same time
+class TaskGraph
+{
+public:
+	typedef std::function<void()> TaskFunc;
+
+	TaskGraph(class JobSystem* jobs);
+	~TaskGraph();
+
+	// Add a task, and returns its ID
+	// (main thread tasks always run on the thread that calls Run,
+	// which is needed for anything touching SDL or OpenGL)
+	int AddTask(const std::string& name, TaskFunc func, bool mainThread = false);
+	// Task "after" can't start until task "before" finishes
+	void AddDependency(int before, int after);
+
+	// Run all the tasks, and return once they've all finished
+	void Run();
+private:
+	struct Task
+	{
+		std::string mName;
+		TaskFunc mFunc;
+		bool mMainThread;
+		// Tasks that depend on this one
+		std::vector<int> mDependents;
+		int mNumDependencies;
+		// Dependencies still running (during Run)
+		std::atomic<int> mRemaining;
+	};
+
+	// Queue a task whose dependencies are all done
+	void Schedule(int taskID);
+	void Execute(int taskID);
+
+	class JobSystem* mJobs;
+	std::vector<Task*> mTasks;
+	// Main thread tasks that are ready to run
+	std::vector<int> mMainThreadReady;
+	std::mutex mMainThreadMutex;
+	std::atomic<int> mNumFinished;
+};
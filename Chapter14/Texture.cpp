@@ -7,14 +7,38 @@
 // ----------------------------------------------------------------
 
 #include "Texture.h"
+#include "TextureCooker.h"
 #include <SOIL/SOIL.h>
 #include <GL/glew.h>
 #include <SDL/SDL.h>
+#include <algorithm>
+
+namespace
+{
+	// Trilinear filtering, plus anisotropic filtering if supported
+	void SetMipmapFiltering()
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		if (GLEW_EXT_texture_filter_anisotropic)
+		{
+			// Get the maximum anisotropy value
+			GLfloat largest;
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &largest);
+			// Enable it
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, largest);
+		}
+	}
+}
 
 Texture::Texture()
 :mTextureID(0)
 ,mWidth(0)
 ,mHeight(0)
+,mUVMin(Vector2::Zero)
+,mUVMax(1.0f, 1.0f)
+,mOwnsTexture(true)
 {
 	
 }
@@ -26,54 +50,206 @@ Texture::~Texture()
 
 bool Texture::Load(const std::string& fileName)
 {
-	mFileName = fileName;
-	int channels = 0;
-	
-	unsigned char* image = SOIL_load_image(fileName.c_str(),
-										   &mWidth, &mHeight, &channels, SOIL_LOAD_AUTO);
+	// Use the block compressed version if the GPU supports it
+	ImageData data;
+	if (!LoadImageData(fileName, GLEW_EXT_texture_compression_s3tc != 0, data))
+	{
+		return false;
+	}
+	Create(fileName, data);
+	return true;
+}
+
+bool Texture::LoadImageData(const std::string& fileName, bool compress,
+	ImageData& outData)
+{
+	outData.mCompressed = compress;
+	if (compress)
+	{
+		// Cook it the first time the texture loads
+		if (!TextureCooker::Load(fileName + ".gptex", outData.mCooked))
+		{
+			int channels = 0;
+			int width = 0;
+			int height = 0;
+			unsigned char* image = SOIL_load_image(fileName.c_str(),
+				&width, &height, &channels, SOIL_LOAD_RGBA);
+			if (image == nullptr)
+			{
+				SDL_Log("SOIL failed to load image %s: %s", fileName.c_str(), SOIL_last_result());
+				return false;
+			}
+			TextureCooker::Cook(image, width, height, outData.mCooked);
+			SOIL_free_image_data(image);
+			TextureCooker::Save(fileName + ".gptex", outData.mCooked);
+		}
+		outData.mWidth = outData.mCooked.mWidth;
+		outData.mHeight = outData.mCooked.mHeight;
+		outData.mChannels = 4;
+		return true;
+	}
+
+	unsigned char* image = SOIL_load_image(fileName.c_str(), &outData.mWidth,
+		&outData.mHeight, &outData.mChannels, SOIL_LOAD_AUTO);
 	
 	if (image == nullptr)
 	{
 		SDL_Log("SOIL failed to load image %s: %s", fileName.c_str(), SOIL_last_result());
 		return false;
 	}
-	
-	int format = GL_RGB;
-	if (channels == 4)
+	outData.mPixels.assign(image,
+		image + outData.mWidth * outData.mHeight * outData.mChannels);
+	SOIL_free_image_data(image);
+	return true;
+}
+
+void Texture::Create(const std::string& fileName, const ImageData& data,
+	unsigned int pixelBuffer)
+{
+	mFileName = fileName;
+	mWidth = data.mWidth;
+	mHeight = data.mHeight;
+	mOwnsTexture = true;
+
+	// Each mip to upload (just the first for uncompressed data,
+	// which gets its mips generated)
+	std::vector<const std::vector<unsigned char>*> levels;
+	if (data.mCompressed)
 	{
-		format = GL_RGBA;
+		for (const auto& mip : data.mCooked.mMips)
+		{
+			levels.emplace_back(&mip);
+		}
 	}
-	
+	else
+	{
+		levels.emplace_back(&data.mPixels);
+	}
+
+	// Copy everything into the pixel buffer, so the driver can transfer
+	// it to the texture without stalling to copy out of our memory
+	std::vector<size_t> offsets;
+	size_t totalSize = 0;
+	for (auto level : levels)
+	{
+		offsets.emplace_back(totalSize);
+		totalSize += level->size();
+	}
+	unsigned char* buffer = nullptr;
+	if (pixelBuffer != 0)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+		// (Orphan last upload's storage, rather than waiting for it)
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+		buffer = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+			0, totalSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+		if (buffer != nullptr)
+		{
+			for (size_t i = 0; i < levels.size(); i++)
+			{
+				std::copy(levels[i]->begin(), levels[i]->end(), buffer + offsets[i]);
+			}
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+		else
+		{
+			// Fall back to uploading from our memory
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+	}
+	// With a pixel buffer bound, the data pointers are offsets into it
+	auto levelData = [&](size_t i) -> const void* {
+		if (buffer != nullptr)
+		{
+			return reinterpret_cast<const void*>(offsets[i]);
+		}
+		return levels[i]->data();
+	};
+
 	glGenTextures(1, &mTextureID);
 	glBindTexture(GL_TEXTURE_2D, mTextureID);
-	
-	glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, format,
-				 GL_UNSIGNED_BYTE, image);
-	
-	SOIL_free_image_data(image);
-	
-	// Generate mipmaps for texture
-	glGenerateMipmap(GL_TEXTURE_2D);
+
+	if (data.mCompressed)
+	{
+		// Upload every mip as is
+		int width = mWidth;
+		int height = mHeight;
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i),
+				data.mCooked.mFormat, width, height, 0,
+				static_cast<GLsizei>(levels[i]->size()), levelData(i));
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+			static_cast<GLint>(levels.size()) - 1);
+	}
+	else
+	{
+		int format = GL_RGB;
+		if (data.mChannels == 4)
+		{
+			format = GL_RGBA;
+		}
+		glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, format,
+					 GL_UNSIGNED_BYTE, levelData(0));
+		// Generate mipmaps for texture
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
 	// Enable linear filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	SetMipmapFiltering();
 
-	// Enable anisotropic filtering, if supported
-	if (GLEW_EXT_texture_filter_anisotropic)
+	if (buffer != nullptr)
 	{
-		// Get the maximum anisotropy value
-		GLfloat largest;
-		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &largest);
-		// Enable it
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, largest);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 	}
-	
+}
+
+void Texture::SetPlaceholder(const std::string& fileName, Texture* placeholder)
+{
+	mFileName = fileName;
+	mTextureID = placeholder->mTextureID;
+	mWidth = placeholder->mWidth;
+	mHeight = placeholder->mHeight;
+	mOwnsTexture = false;
+}
+
+bool Texture::LoadInfo(const std::string& fileName)
+{
+	mFileName = fileName;
+
+	// The cooked file's header has the size, without decoding anything
+	TextureCooker::Cooked cooked;
+	if (TextureCooker::Load(fileName + ".gptex", cooked, true))
+	{
+		mWidth = cooked.mWidth;
+		mHeight = cooked.mHeight;
+		return true;
+	}
+
+	int channels = 0;
+
+	unsigned char* image = SOIL_load_image(fileName.c_str(),
+										   &mWidth, &mHeight, &channels, SOIL_LOAD_AUTO);
+
+	if (image == nullptr)
+	{
+		SDL_Log("SOIL failed to load image %s: %s", fileName.c_str(), SOIL_last_result());
+		return false;
+	}
+
+	SOIL_free_image_data(image);
 	return true;
 }
 
 void Texture::Unload()
 {
-	glDeleteTextures(1, &mTextureID);
+	// Textures loaded with LoadInfo never made a GL texture
+	if (mTextureID != 0 && mOwnsTexture)
+	{
+		glDeleteTextures(1, &mTextureID);
+	}
 }
 
 void Texture::CreateFromSurface(SDL_Surface* surface)
@@ -100,7 +276,14 @@ void Texture::CreateForRendering(int width, int height, unsigned int format)
 	glGenTextures(1, &mTextureID);
 	glBindTexture(GL_TEXTURE_2D, mTextureID);
 	// Set the image width/height with null initial data
-	glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, GL_RGB,
+	// (depth formats need a depth transfer format, even with no data)
+	GLenum dataFormat = GL_RGB;
+	if (format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 ||
+		format == GL_DEPTH_COMPONENT32F)
+	{
+		dataFormat = GL_DEPTH_COMPONENT;
+	}
+	glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, dataFormat,
 		GL_FLOAT, nullptr);
 
 	// For a texture we'll render to, just use nearest neighbor
@@ -108,6 +291,20 @@ void Texture::CreateForRendering(int width, int height, unsigned int format)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 }
 
+void Texture::CreateFromAtlas(const std::string& fileName, unsigned int textureID,
+	int x, int y, int width, int height, int atlasWidth, int atlasHeight)
+{
+	mFileName = fileName;
+	mTextureID = textureID;
+	mOwnsTexture = false;
+	mWidth = width;
+	mHeight = height;
+	mUVMin = Vector2(static_cast<float>(x) / atlasWidth,
+		static_cast<float>(y) / atlasHeight);
+	mUVMax = Vector2(static_cast<float>(x + width) / atlasWidth,
+		static_cast<float>(y + height) / atlasHeight);
+}
+
 void Texture::SetActive(int index)
 {
 	glActiveTexture(GL_TEXTURE0 + index);
@@ -6,24 +6,60 @@
 // See LICENSE in root directory for full details.
 // ----------------------------------------------------------------
 
+#pragma once
 #include <string>
+#include <vector>
+#include "Math.h"
+#include "TextureCooker.h"
 
 class Texture
 {
 public:
+	// Decoded image, ready to upload
+	struct ImageData
+	{
+		// Either block compressed mips, or uncompressed pixels
+		bool mCompressed;
+		TextureCooker::Cooked mCooked;
+		std::vector<unsigned char> mPixels;
+		int mWidth;
+		int mHeight;
+		int mChannels;
+	};
+
 	Texture();
 	~Texture();
 	
 	bool Load(const std::string& fileName);
+	// Only loads the dimensions, without creating a GL texture
+	bool LoadInfo(const std::string& fileName);
 	void Unload();
+	// Read/decode an image file without touching GL, so this can run
+	// on any thread. If compress, uses (or cooks) the .gptex version
+	static bool LoadImageData(const std::string& fileName, bool compress,
+		ImageData& outData);
+	// Upload decoded image data (on the GL thread). If pixelBuffer
+	// isn't 0, the data is copied through that pixel buffer object
+	void Create(const std::string& fileName, const ImageData& data,
+		unsigned int pixelBuffer = 0);
+	// Use another texture's GL texture until this one is created
+	void SetPlaceholder(const std::string& fileName, Texture* placeholder);
 	void CreateFromSurface(struct SDL_Surface* surface);
 	void CreateForRendering(int width, int height, unsigned int format);
+	// Refer to a rectangle of an atlas page, which owns the GL texture
+	// (so textures made this way shouldn't be unloaded)
+	void CreateFromAtlas(const std::string& fileName, unsigned int textureID,
+		int x, int y, int width, int height, int atlasWidth, int atlasHeight);
 	
 	void SetActive(int index = 0);
 	
 	int GetWidth() const { return mWidth; }
 	int GetHeight() const { return mHeight; }
 	unsigned int GetTextureID() const { return mTextureID; }
+	// The part of the GL texture this covers
+	// (top left/bottom right, the whole texture unless it's in an atlas)
+	const Vector2& GetUVMin() const { return mUVMin; }
+	const Vector2& GetUVMax() const { return mUVMax; }
 
 	const std::string& GetFileName() const { return mFileName; }
 private:
@@ -31,4 +67,9 @@ private:
 	unsigned int mTextureID;
 	int mWidth;
 	int mHeight;
+	Vector2 mUVMin;
+	Vector2 mUVMax;
+	// False if the GL texture belongs to something else
+	// (an atlas page or a placeholder)
+	bool mOwnsTexture;
 };
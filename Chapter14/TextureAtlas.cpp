@@ -0,0 +1,292 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "TextureAtlas.h"
+#include "Texture.h"
+#include "LevelLoader.h"
+#include <SOIL/SOIL.h>
+#include <GL/glew.h>
+#include <SDL/SDL.h>
+#include <algorithm>
+
+namespace
+{
+	const int AtlasVersion = 1;
+	// Empty pixels around each image, so linear filtering
+	// at its edges doesn't blend in its neighbors
+	const int Padding = 2;
+
+	struct Image
+	{
+		std::string mFileName;
+		unsigned char* mPixels;
+		int mWidth;
+		int mHeight;
+	};
+}
+
+TextureAtlas::Skyline::Skyline(int width, int height)
+	:mWidth(width)
+	,mHeight(height)
+{
+	// Starts as one flat segment along the bottom
+	Segment s;
+	s.mX = 0;
+	s.mY = 0;
+	s.mWidth = width;
+	mSegments.emplace_back(s);
+}
+
+int TextureAtlas::Skyline::FitAt(size_t i, int width, int height) const
+{
+	if (mSegments[i].mX + width > mWidth)
+	{
+		return -1;
+	}
+	// The rectangle rests on the highest segment under it
+	int y = 0;
+	int widthLeft = width;
+	while (widthLeft > 0)
+	{
+		y = std::max(y, mSegments[i].mY);
+		if (y + height > mHeight)
+		{
+			return -1;
+		}
+		widthLeft -= mSegments[i].mWidth;
+		i++;
+	}
+	return y;
+}
+
+bool TextureAtlas::Skyline::Insert(int width, int height, int& outX, int& outY)
+{
+	// Find the spot with the lowest top edge (ties go to the
+	// narrower segment, which leaves bigger gaps elsewhere)
+	size_t best = mSegments.size();
+	int bestTop = mHeight + 1;
+	int bestWidth = mWidth + 1;
+	for (size_t i = 0; i < mSegments.size(); i++)
+	{
+		int y = FitAt(i, width, height);
+		if (y >= 0 && (y + height < bestTop ||
+			(y + height == bestTop && mSegments[i].mWidth < bestWidth)))
+		{
+			best = i;
+			bestTop = y + height;
+			bestWidth = mSegments[i].mWidth;
+		}
+	}
+	if (best == mSegments.size())
+	{
+		return false;
+	}
+	outX = mSegments[best].mX;
+	outY = bestTop - height;
+
+	// The rectangle's top becomes a new segment...
+	Segment s;
+	s.mX = outX;
+	s.mY = bestTop;
+	s.mWidth = width;
+	mSegments.insert(mSegments.begin() + best, s);
+
+	// ...which hides the segments under it
+	size_t i = best + 1;
+	while (i < mSegments.size())
+	{
+		Segment& next = mSegments[i];
+		int covered = s.mX + s.mWidth - next.mX;
+		if (covered <= 0)
+		{
+			break;
+		}
+		if (covered < next.mWidth)
+		{
+			next.mX += covered;
+			next.mWidth -= covered;
+			break;
+		}
+		mSegments.erase(mSegments.begin() + i);
+	}
+
+	// Merge neighbors at the same height
+	for (i = 0; i + 1 < mSegments.size();)
+	{
+		if (mSegments[i].mY == mSegments[i + 1].mY)
+		{
+			mSegments[i].mWidth += mSegments[i + 1].mWidth;
+			mSegments.erase(mSegments.begin() + i + 1);
+		}
+		else
+		{
+			i++;
+		}
+	}
+	return true;
+}
+
+TextureAtlas::TextureAtlas()
+	:mPageSize(1024)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+}
+
+bool TextureAtlas::Load(const std::string& fileName)
+{
+	rapidjson::Document doc;
+	if (!LevelLoader::LoadJSON(fileName, doc))
+	{
+		SDL_Log("Failed to load atlas %s", fileName.c_str());
+		return false;
+	}
+
+	int version = 0;
+	if (!JsonHelper::GetInt(doc, "version", version) ||
+		version != AtlasVersion)
+	{
+		SDL_Log("Atlas %s unknown format", fileName.c_str());
+		return false;
+	}
+	JsonHelper::GetInt(doc, "pageSize", mPageSize);
+
+	if (!doc.HasMember("textures") || !doc["textures"].IsArray())
+	{
+		SDL_Log("Atlas %s has no textures", fileName.c_str());
+		return false;
+	}
+	const rapidjson::Value& textures = doc["textures"];
+
+	// Load every image first, so they can be packed tallest first
+	// (which packs much tighter than packing them in file order)
+	std::vector<Image> images;
+	for (rapidjson::SizeType i = 0; i < textures.Size(); i++)
+	{
+		if (!textures[i].IsString())
+		{
+			continue;
+		}
+		Image image;
+		image.mFileName = textures[i].GetString();
+		int channels = 0;
+		// (Always RGBA, since every image shares the page)
+		image.mPixels = SOIL_load_image(image.mFileName.c_str(),
+			&image.mWidth, &image.mHeight, &channels, SOIL_LOAD_RGBA);
+		if (image.mPixels == nullptr)
+		{
+			SDL_Log("SOIL failed to load image %s: %s", image.mFileName.c_str(),
+				SOIL_last_result());
+			continue;
+		}
+		images.emplace_back(image);
+	}
+	std::sort(images.begin(), images.end(), [](const Image& a, const Image& b) {
+		if (a.mHeight != b.mHeight)
+		{
+			return a.mHeight > b.mHeight;
+		}
+		return a.mWidth > b.mWidth;
+	});
+
+	for (Image& image : images)
+	{
+		// Images that can't fit are left out, and load on their own
+		if (!Add(image.mFileName, image.mWidth, image.mHeight, image.mPixels))
+		{
+			SDL_Log("%s is too large for atlas %s", image.mFileName.c_str(),
+				fileName.c_str());
+		}
+		SOIL_free_image_data(image.mPixels);
+	}
+	return true;
+}
+
+void TextureAtlas::Unload()
+{
+	for (auto& iter : mTextures)
+	{
+		// (The GL texture is the page's, so don't unload these)
+		delete iter.second;
+	}
+	mTextures.clear();
+	for (Page& page : mPages)
+	{
+		glDeleteTextures(1, &page.mTextureID);
+	}
+	mPages.clear();
+}
+
+Texture* TextureAtlas::GetTexture(const std::string& fileName) const
+{
+	auto iter = mTextures.find(fileName);
+	if (iter != mTextures.end())
+	{
+		return iter->second;
+	}
+	return nullptr;
+}
+
+Texture* TextureAtlas::Add(const std::string& name, int width, int height,
+	const unsigned char* pixels)
+{
+	int x = 0;
+	int y = 0;
+	int paddedWidth = width + Padding * 2;
+	int paddedHeight = height + Padding * 2;
+	if (paddedWidth > mPageSize || paddedHeight > mPageSize)
+	{
+		return nullptr;
+	}
+
+	// Use the first page with space (with a new page if none have space)
+	Page* page = nullptr;
+	for (Page& p : mPages)
+	{
+		if (p.mSkyline.Insert(paddedWidth, paddedHeight, x, y))
+		{
+			page = &p;
+			break;
+		}
+	}
+	if (!page)
+	{
+		// Start a new page, cleared to transparent
+		Page newPage{ 0, Skyline(mPageSize, mPageSize) };
+		std::vector<unsigned char> clear(mPageSize * mPageSize * 4, 0);
+		glGenTextures(1, &newPage.mTextureID);
+		glBindTexture(GL_TEXTURE_2D, newPage.mTextureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mPageSize, mPageSize, 0, GL_RGBA,
+			GL_UNSIGNED_BYTE, clear.data());
+		// No mipmaps, since they'd blend neighboring images together
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		newPage.mSkyline.Insert(paddedWidth, paddedHeight, x, y);
+		mPages.emplace_back(newPage);
+		page = &mPages.back();
+	}
+
+	// Copy the image into its spot
+	x += Padding;
+	y += Padding;
+	glBindTexture(GL_TEXTURE_2D, page->mTextureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA,
+		GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	Texture* tex = new Texture();
+	tex->CreateFromAtlas(name, page->mTextureID, x, y, width, height,
+		mPageSize, mPageSize);
+	mTextures.emplace(name, tex);
+	return tex;
+}
@@ -0,0 +1,75 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Packs many small images into a few shared GL textures ("pages"),
+// so sprites and UI that use them don't need to rebind textures.
+// Each packed image gets a Texture that refers to its rectangle
+// of the page, which can be used like any other Texture.
+// Images can be packed all at once from a file, or added as needed
+class TextureAtlas
+{
+public:
+	TextureAtlas();
+	~TextureAtlas();
+
+	// Pack every image listed in a .gpatlas file
+	bool Load(const std::string& fileName);
+	// Delete the pages and their textures
+	void Unload();
+	// Pack RGBA pixels (tightly packed rows) under this name, returning
+	// nullptr if the image is too large for a page
+	class Texture* Add(const std::string& name, int width, int height,
+		const unsigned char* pixels);
+	// (Only before anything is added)
+	void SetPageSize(int pageSize) { mPageSize = pageSize; }
+
+	// Returns the packed texture for this image,
+	// or nullptr if it isn't in the atlas
+	class Texture* GetTexture(const std::string& fileName) const;
+	size_t GetNumPages() const { return mPages.size(); }
+private:
+	// Finds space for rectangles in a page with a skyline, the top edge
+	// of everything placed so far. Rectangles go wherever they leave
+	// the lowest top edge, which wastes little space for UI sized images
+	class Skyline
+	{
+	public:
+		Skyline(int width, int height);
+		// Finds and reserves space for a rectangle, returning false if full
+		bool Insert(int width, int height, int& outX, int& outY);
+	private:
+		// Returns the y a rectangle starting at segment i would sit at,
+		// or -1 if it doesn't fit there
+		int FitAt(size_t i, int width, int height) const;
+
+		struct Segment
+		{
+			int mX;
+			int mY;
+			int mWidth;
+		};
+		std::vector<Segment> mSegments;
+		int mWidth;
+		int mHeight;
+	};
+
+	struct Page
+	{
+		unsigned int mTextureID;
+		Skyline mSkyline;
+	};
+
+	std::vector<Page> mPages;
+	std::unordered_map<std::string, class Texture*> mTextures;
+	int mPageSize;
+};
@@ -0,0 +1,341 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "TextureCooker.h"
+#include <GL/glew.h>
+#include <SDL/SDL.h>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+	const int BinaryVersion = 1;
+	struct TextureBinHeader
+	{
+		// Signature for file type
+		char mSignature[4] = { 'G', 'T', 'E', 'X' };
+		// Version
+		uint32_t mVersion = BinaryVersion;
+		// GL internal format, and size of the largest mip
+		uint32_t mFormat = 0;
+		uint32_t mWidth = 0;
+		uint32_t mHeight = 0;
+		uint32_t mNumMips = 0;
+	};
+
+	uint16_t To565(int r, int g, int b)
+	{
+		return static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 |
+			((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+	}
+
+	void From565(uint16_t c, int* rgb)
+	{
+		int r = (c >> 11) & 31;
+		int g = (c >> 5) & 63;
+		int b = c & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	// Halve an RGBA image with a box filter
+	// (odd sizes reuse the last row/column)
+	void Downsample(const std::vector<uint8_t>& src, int width, int height,
+		std::vector<uint8_t>& dst, int& outWidth, int& outHeight)
+	{
+		outWidth = std::max(width / 2, 1);
+		outHeight = std::max(height / 2, 1);
+		dst.resize(outWidth * outHeight * 4);
+		for (int y = 0; y < outHeight; y++)
+		{
+			int y0 = std::min(y * 2, height - 1);
+			int y1 = std::min(y * 2 + 1, height - 1);
+			for (int x = 0; x < outWidth; x++)
+			{
+				int x0 = std::min(x * 2, width - 1);
+				int x1 = std::min(x * 2 + 1, width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c] +
+						src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c];
+					dst[(y * outWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+void TextureCooker::Cook(const unsigned char* pixels, int width, int height,
+	Cooked& outCooked)
+{
+	// Only use the larger BC3 if there's any transparency
+	bool hasAlpha = false;
+	for (int i = 0; i < width * height && !hasAlpha; i++)
+	{
+		hasAlpha = pixels[i * 4 + 3] != 255;
+	}
+	outCooked.mFormat = hasAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT :
+		GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	outCooked.mWidth = width;
+	outCooked.mHeight = height;
+	outCooked.mMips.clear();
+
+	std::vector<uint8_t> level(pixels, pixels + width * height * 4);
+	std::vector<uint8_t> next;
+	int w = width;
+	int h = height;
+	while (true)
+	{
+		// Compress this level a block at a time
+		// (blocks past the edge repeat the edge pixels)
+		int blocksX = (w + 3) / 4;
+		int blocksY = (h + 3) / 4;
+		size_t blockSize = hasAlpha ? 16 : 8;
+		std::vector<uint8_t> mip(blocksX * blocksY * blockSize);
+		uint8_t* out = mip.data();
+		uint8_t block[16 * 4];
+		for (int by = 0; by < blocksY; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				for (int i = 0; i < 16; i++)
+				{
+					int x = std::min(bx * 4 + i % 4, w - 1);
+					int y = std::min(by * 4 + i / 4, h - 1);
+					const uint8_t* p = &level[(y * w + x) * 4];
+					std::copy(p, p + 4, &block[i * 4]);
+				}
+				if (hasAlpha)
+				{
+					EncodeAlphaBlock(block, out);
+					out += 8;
+				}
+				EncodeColorBlock(block, out);
+				out += 8;
+			}
+		}
+		outCooked.mMips.emplace_back(std::move(mip));
+
+		if (w == 1 && h == 1)
+		{
+			break;
+		}
+		int nextW = 0;
+		int nextH = 0;
+		Downsample(level, w, h, next, nextW, nextH);
+		level.swap(next);
+		w = nextW;
+		h = nextH;
+	}
+}
+
+void TextureCooker::EncodeColorBlock(const uint8_t* block, uint8_t* out)
+{
+	// Use the corners of the colors' bounding box as the end points,
+	// flipped along red/blue to lie along the colors' main diagonal
+	int minC[3] = { 255, 255, 255 };
+	int maxC[3] = { 0, 0, 0 };
+	int mean[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			minC[c] = std::min(minC[c], static_cast<int>(block[i * 4 + c]));
+			maxC[c] = std::max(maxC[c], static_cast<int>(block[i * 4 + c]));
+			mean[c] += block[i * 4 + c];
+		}
+	}
+	int covRG = 0;
+	int covBG = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int r = block[i * 4] * 16 - mean[0];
+		int g = block[i * 4 + 1] * 16 - mean[1];
+		int b = block[i * 4 + 2] * 16 - mean[2];
+		covRG += r * g;
+		covBG += b * g;
+	}
+	if (covRG < 0)
+	{
+		std::swap(minC[0], maxC[0]);
+	}
+	if (covBG < 0)
+	{
+		std::swap(minC[2], maxC[2]);
+	}
+	// Inset the box a little, since the ends are rarely hit exactly
+	for (int c = 0; c < 3; c++)
+	{
+		int inset = (maxC[c] - minC[c]) / 16;
+		maxC[c] -= inset;
+		minC[c] += inset;
+	}
+
+	uint16_t c0 = To565(maxC[0], maxC[1], maxC[2]);
+	uint16_t c1 = To565(minC[0], minC[1], minC[2]);
+	// The first color has to be larger for four color mode
+	if (c0 < c1)
+	{
+		std::swap(c0, c1);
+	}
+
+	uint32_t indices = 0;
+	if (c0 != c1)
+	{
+		int palette[4][3];
+		From565(c0, palette[0]);
+		From565(c1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (palette[0][c] * 2 + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + palette[1][c] * 2) / 3;
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			int bestDist = INT32_MAX;
+			for (int p = 0; p < 4; p++)
+			{
+				int dist = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					int d = block[i * 4 + c] - palette[p][c];
+					dist += d * d;
+				}
+				if (dist < bestDist)
+				{
+					bestDist = dist;
+					best = p;
+				}
+			}
+			indices |= static_cast<uint32_t>(best) << (i * 2);
+		}
+	}
+
+	// (Little endian, like the GPU reads it)
+	out[0] = static_cast<uint8_t>(c0);
+	out[1] = static_cast<uint8_t>(c0 >> 8);
+	out[2] = static_cast<uint8_t>(c1);
+	out[3] = static_cast<uint8_t>(c1 >> 8);
+	for (int i = 0; i < 4; i++)
+	{
+		out[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+	}
+}
+
+void TextureCooker::EncodeAlphaBlock(const uint8_t* block, uint8_t* out)
+{
+	int a0 = 0;
+	int a1 = 255;
+	for (int i = 0; i < 16; i++)
+	{
+		a0 = std::max(a0, static_cast<int>(block[i * 4 + 3]));
+		a1 = std::min(a1, static_cast<int>(block[i * 4 + 3]));
+	}
+
+	// With a0 > a1, there are six steps between them
+	uint64_t indices = 0;
+	if (a0 != a1)
+	{
+		int palette[8];
+		palette[0] = a0;
+		palette[1] = a1;
+		for (int p = 1; p < 7; p++)
+		{
+			palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			int bestDist = 256;
+			for (int p = 0; p < 8; p++)
+			{
+				int dist = std::abs(block[i * 4 + 3] - palette[p]);
+				if (dist < bestDist)
+				{
+					bestDist = dist;
+					best = p;
+				}
+			}
+			indices |= static_cast<uint64_t>(best) << (i * 3);
+		}
+	}
+
+	out[0] = static_cast<uint8_t>(a0);
+	out[1] = static_cast<uint8_t>(a1);
+	for (int i = 0; i < 6; i++)
+	{
+		out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+	}
+}
+
+bool TextureCooker::Save(const std::string& fileName, const Cooked& cooked)
+{
+	TextureBinHeader header;
+	header.mFormat = cooked.mFormat;
+	header.mWidth = static_cast<uint32_t>(cooked.mWidth);
+	header.mHeight = static_cast<uint32_t>(cooked.mHeight);
+	header.mNumMips = static_cast<uint32_t>(cooked.mMips.size());
+
+	std::ofstream outFile(fileName, std::ios::out | std::ios::binary);
+	if (!outFile.is_open())
+	{
+		SDL_Log("Failed to write cooked texture %s", fileName.c_str());
+		return false;
+	}
+	outFile.write(reinterpret_cast<char*>(&header), sizeof(header));
+	// Each mip is its size in bytes, then its blocks
+	for (const auto& mip : cooked.mMips)
+	{
+		uint32_t size = static_cast<uint32_t>(mip.size());
+		outFile.write(reinterpret_cast<char*>(&size), sizeof(size));
+		outFile.write(reinterpret_cast<const char*>(mip.data()), size);
+	}
+	return true;
+}
+
+bool TextureCooker::Load(const std::string& fileName, Cooked& outCooked,
+	bool infoOnly)
+{
+	std::ifstream inFile(fileName, std::ios::in | std::ios::binary);
+	if (!inFile.is_open())
+	{
+		return false;
+	}
+
+	// Validate the header signature and version
+	TextureBinHeader header;
+	inFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+	char* sig = header.mSignature;
+	if (!inFile || sig[0] != 'G' || sig[1] != 'T' || sig[2] != 'E' ||
+		sig[3] != 'X' || header.mVersion != BinaryVersion)
+	{
+		return false;
+	}
+	outCooked.mFormat = header.mFormat;
+	outCooked.mWidth = static_cast<int>(header.mWidth);
+	outCooked.mHeight = static_cast<int>(header.mHeight);
+	outCooked.mMips.clear();
+	if (infoOnly)
+	{
+		return true;
+	}
+
+	outCooked.mMips.resize(header.mNumMips);
+	for (auto& mip : outCooked.mMips)
+	{
+		uint32_t size = 0;
+		inFile.read(reinterpret_cast<char*>(&size), sizeof(size));
+		mip.resize(size);
+		inFile.read(reinterpret_cast<char*>(mip.data()), size);
+	}
+	// (A truncated file is cooked again)
+	return static_cast<bool>(inFile);
+}
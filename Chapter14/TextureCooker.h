@@ -0,0 +1,42 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Converts images to block compressed textures (BC1 for opaque images,
+// BC3 for images with alpha) with their whole mip chain, and saves/loads
+// them as .gptex files, so they can be uploaded without any decoding
+class TextureCooker
+{
+public:
+	struct Cooked
+	{
+		// GL internal format (one of the S3TC formats)
+		unsigned int mFormat;
+		int mWidth;
+		int mHeight;
+		// Compressed blocks for each mip, largest first
+		std::vector<std::vector<uint8_t>> mMips;
+	};
+
+	// Compress RGBA pixels, and make every mip level down to 1x1
+	static void Cook(const unsigned char* pixels, int width, int height,
+		Cooked& outCooked);
+
+	static bool Save(const std::string& fileName, const Cooked& cooked);
+	// If infoOnly, just loads the format and dimensions
+	static bool Load(const std::string& fileName, Cooked& outCooked,
+		bool infoOnly = false);
+private:
+	// Each encodes a 4x4 block of RGBA pixels
+	static void EncodeColorBlock(const uint8_t* block, uint8_t* out);
+	static void EncodeAlphaBlock(const uint8_t* block, uint8_t* out);
+};
@@ -0,0 +1,665 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "TransformStore.h"
+#include "Profiler.h"
+#include "Actor.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TRANSFORM_STORE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	// Move the last element into index, then shrink by one
+	template <typename T>
+	void SwapPop(std::vector<T>& v, size_t index)
+	{
+		v[index] = v.back();
+		v.pop_back();
+	}
+
+	// Blocks of four entries per job when computing world transforms
+	const size_t BlocksPerJob = 64;
+	// Entries per job when computing render transforms
+	const size_t RenderEntriesPerJob = 256;
+	// No entries have a parent
+	const size_t NoChildren = static_cast<size_t>(-1);
+
+	// Rearrange v so that entry i is the old entry order[i]
+	template <typename T>
+	void Reorder(std::vector<T>& v, const std::vector<int>& order)
+	{
+		std::vector<T> sorted;
+		sorted.reserve(v.size());
+		for (int index : order)
+		{
+			sorted.emplace_back(v[index]);
+		}
+		v.swap(sorted);
+	}
+
+	// Same, but also remap the indices stored in v
+	void ReorderLinks(std::vector<int>& v, const std::vector<int>& order,
+		const std::vector<int>& newIndices)
+	{
+		Reorder(v, order);
+		for (int& link : v)
+		{
+			if (link >= 0)
+			{
+				link = newIndices[link];
+			}
+		}
+	}
+}
+
+TransformStore::TransformStore(JobSystem* jobs)
+	:mFirstChildIndex(NoChildren)
+	,mNeedsSort(false)
+	,mJobs(jobs)
+{
+}
+
+int TransformStore::Add(Actor* owner)
+{
+	int index = static_cast<int>(mOwners.size());
+	mPosX.emplace_back(0.0f);
+	mPosY.emplace_back(0.0f);
+	mPosZ.emplace_back(0.0f);
+	mRotX.emplace_back(Quaternion::Identity.x);
+	mRotY.emplace_back(Quaternion::Identity.y);
+	mRotZ.emplace_back(Quaternion::Identity.z);
+	mRotW.emplace_back(Quaternion::Identity.w);
+	mScale.emplace_back(1.0f);
+	mPrevPositions.emplace_back(Vector3::Zero);
+	mPrevRotations.emplace_back(Quaternion::Identity);
+	mPrevScales.emplace_back(1.0f);
+	mWorldTransforms.emplace_back(Matrix4::Identity);
+	mRenderTransforms.emplace_back(Matrix4::Identity);
+	mDirty.emplace_back(1);
+	mMoved.emplace_back(0);
+	mHasHistory.emplace_back(0);
+	// Always inform the owner of its first world transform
+	mChanged.emplace_back(1);
+	mOwners.emplace_back(owner);
+	mParents.emplace_back(-1);
+	mFirstChildren.emplace_back(-1);
+	mNextSiblings.emplace_back(-1);
+	return index;
+}
+
+void TransformStore::Remove(int index)
+{
+	// Detach any children, keeping them where they are in the world
+	int child = mFirstChildren[index];
+	while (child >= 0)
+	{
+		int next = mNextSiblings[child];
+		Vector3 pos;
+		Quaternion rot;
+		float scale;
+		GetWorldPose(child, pos, rot, scale);
+		mParents[child] = -1;
+		mNextSiblings[child] = -1;
+		SetPosition(child, pos);
+		SetRotation(child, rot);
+		SetScale(child, scale);
+		// Its previous transform was relative to the old parent,
+		// so don't interpolate from it
+		mHasHistory[child] = 0;
+		child = next;
+	}
+	mFirstChildren[index] = -1;
+	Unlink(index);
+
+	// The last entry is about to move into this slot, so point
+	// its parent and children at the new index
+	int last = static_cast<int>(mOwners.size()) - 1;
+	if (last != index)
+	{
+		int parent = mParents[last];
+		if (parent >= 0)
+		{
+			if (mFirstChildren[parent] == last)
+			{
+				mFirstChildren[parent] = index;
+			}
+			else
+			{
+				int sibling = mFirstChildren[parent];
+				while (mNextSiblings[sibling] != last)
+				{
+					sibling = mNextSiblings[sibling];
+				}
+				mNextSiblings[sibling] = index;
+			}
+		}
+		for (child = mFirstChildren[last]; child >= 0; child = mNextSiblings[child])
+		{
+			mParents[child] = index;
+		}
+	}
+
+	size_t i = static_cast<size_t>(index);
+	SwapPop(mPosX, i);
+	SwapPop(mPosY, i);
+	SwapPop(mPosZ, i);
+	SwapPop(mRotX, i);
+	SwapPop(mRotY, i);
+	SwapPop(mRotZ, i);
+	SwapPop(mRotW, i);
+	SwapPop(mScale, i);
+	SwapPop(mPrevPositions, i);
+	SwapPop(mPrevRotations, i);
+	SwapPop(mPrevScales, i);
+	SwapPop(mWorldTransforms, i);
+	SwapPop(mRenderTransforms, i);
+	SwapPop(mDirty, i);
+	SwapPop(mMoved, i);
+	SwapPop(mHasHistory, i);
+	SwapPop(mChanged, i);
+	SwapPop(mOwners, i);
+	SwapPop(mParents, i);
+	SwapPop(mFirstChildren, i);
+	SwapPop(mNextSiblings, i);
+
+	// Let the owner of the moved entry know where it went
+	if (i < mOwners.size())
+	{
+		mOwners[i]->SetTransformIndex(index);
+
+		// It may now come before its parent
+		int parent = mParents[i];
+		if (parent >= 0)
+		{
+			mNeedsSort = mNeedsSort || parent > index;
+			mFirstChildIndex = std::min(mFirstChildIndex, i);
+		}
+	}
+}
+
+bool TransformStore::SetParent(int index, int parent)
+{
+	if (mParents[index] == parent)
+	{
+		return true;
+	}
+
+	// Can't attach to ourselves or one of our descendants
+	for (int ancestor = parent; ancestor >= 0; ancestor = mParents[ancestor])
+	{
+		if (ancestor == index)
+		{
+			return false;
+		}
+	}
+
+	Unlink(index);
+	if (parent >= 0)
+	{
+		mParents[index] = parent;
+		mNextSiblings[index] = mFirstChildren[parent];
+		mFirstChildren[parent] = index;
+
+		// Parents need to come before their children
+		mNeedsSort = mNeedsSort || parent > index;
+		mFirstChildIndex = std::min(mFirstChildIndex, static_cast<size_t>(index));
+	}
+
+	mDirty[index] = 1;
+	// The relative transform means something different now,
+	// so don't interpolate from the old one
+	mHasHistory[index] = 0;
+	return true;
+}
+
+void TransformStore::Unlink(int index)
+{
+	int parent = mParents[index];
+	if (parent < 0)
+	{
+		return;
+	}
+
+	if (mFirstChildren[parent] == index)
+	{
+		mFirstChildren[parent] = mNextSiblings[index];
+	}
+	else
+	{
+		int sibling = mFirstChildren[parent];
+		while (mNextSiblings[sibling] != index)
+		{
+			sibling = mNextSiblings[sibling];
+		}
+		mNextSiblings[sibling] = mNextSiblings[index];
+	}
+	mParents[index] = -1;
+	mNextSiblings[index] = -1;
+}
+
+void TransformStore::GetWorldPose(int index, Vector3& outPos,
+	Quaternion& outRot, float& outScale) const
+{
+	outPos = GetPosition(index);
+	outRot = GetRotation(index);
+	outScale = mScale[index];
+	// Apply each ancestor's transform in turn
+	for (int parent = mParents[index]; parent >= 0; parent = mParents[parent])
+	{
+		outPos = Vector3::Transform(outPos * mScale[parent], GetRotation(parent)) +
+			GetPosition(parent);
+		outRot = Quaternion::Concatenate(outRot, GetRotation(parent));
+		outScale *= mScale[parent];
+	}
+}
+
+void TransformStore::SortHierarchy()
+{
+	// Roots first, then each level of children in turn
+	std::vector<int> order;
+	order.reserve(mOwners.size());
+	for (size_t i = 0; i < mOwners.size(); i++)
+	{
+		if (mParents[i] < 0)
+		{
+			order.emplace_back(static_cast<int>(i));
+		}
+	}
+	size_t numRoots = order.size();
+	for (size_t head = 0; head < order.size(); head++)
+	{
+		for (int child = mFirstChildren[order[head]]; child >= 0;
+			child = mNextSiblings[child])
+		{
+			order.emplace_back(child);
+		}
+	}
+
+	std::vector<int> newIndices(order.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		newIndices[order[i]] = static_cast<int>(i);
+	}
+
+	Reorder(mPosX, order);
+	Reorder(mPosY, order);
+	Reorder(mPosZ, order);
+	Reorder(mRotX, order);
+	Reorder(mRotY, order);
+	Reorder(mRotZ, order);
+	Reorder(mRotW, order);
+	Reorder(mScale, order);
+	Reorder(mPrevPositions, order);
+	Reorder(mPrevRotations, order);
+	Reorder(mPrevScales, order);
+	Reorder(mWorldTransforms, order);
+	Reorder(mRenderTransforms, order);
+	Reorder(mDirty, order);
+	Reorder(mMoved, order);
+	Reorder(mHasHistory, order);
+	Reorder(mChanged, order);
+	Reorder(mOwners, order);
+	ReorderLinks(mParents, order, newIndices);
+	ReorderLinks(mFirstChildren, order, newIndices);
+	ReorderLinks(mNextSiblings, order, newIndices);
+
+	for (size_t i = 0; i < mOwners.size(); i++)
+	{
+		mOwners[i]->SetTransformIndex(static_cast<int>(i));
+	}
+
+	mFirstChildIndex = numRoots < mOwners.size() ? numRoots : NoChildren;
+	mNeedsSort = false;
+}
+
+void TransformStore::SetPosition(int index, const Vector3& pos)
+{
+	mPosX[index] = pos.x;
+	mPosY[index] = pos.y;
+	mPosZ[index] = pos.z;
+	mDirty[index] = 1;
+	mMoved[index] = 1;
+}
+
+void TransformStore::SetRotation(int index, const Quaternion& rotation)
+{
+	mRotX[index] = rotation.x;
+	mRotY[index] = rotation.y;
+	mRotZ[index] = rotation.z;
+	mRotW[index] = rotation.w;
+	mDirty[index] = 1;
+	mMoved[index] = 1;
+}
+
+void TransformStore::SetScale(int index, float scale)
+{
+	mScale[index] = scale;
+	mDirty[index] = 1;
+	mMoved[index] = 1;
+}
+
+void TransformStore::ComputeMatrix(const Vector3& pos, const Quaternion& q,
+	float scale, Matrix4& outMatrix)
+{
+	// Same as CreateScale * CreateFromQuaternion * CreateTranslation
+	outMatrix.mat[0][0] = scale * (1.0f - 2.0f * q.y * q.y - 2.0f * q.z * q.z);
+	outMatrix.mat[0][1] = scale * (2.0f * q.x * q.y + 2.0f * q.w * q.z);
+	outMatrix.mat[0][2] = scale * (2.0f * q.x * q.z - 2.0f * q.w * q.y);
+	outMatrix.mat[0][3] = 0.0f;
+
+	outMatrix.mat[1][0] = scale * (2.0f * q.x * q.y - 2.0f * q.w * q.z);
+	outMatrix.mat[1][1] = scale * (1.0f - 2.0f * q.x * q.x - 2.0f * q.z * q.z);
+	outMatrix.mat[1][2] = scale * (2.0f * q.y * q.z + 2.0f * q.w * q.x);
+	outMatrix.mat[1][3] = 0.0f;
+
+	outMatrix.mat[2][0] = scale * (2.0f * q.x * q.z + 2.0f * q.w * q.y);
+	outMatrix.mat[2][1] = scale * (2.0f * q.y * q.z - 2.0f * q.w * q.x);
+	outMatrix.mat[2][2] = scale * (1.0f - 2.0f * q.x * q.x - 2.0f * q.y * q.y);
+	outMatrix.mat[2][3] = 0.0f;
+
+	outMatrix.mat[3][0] = pos.x;
+	outMatrix.mat[3][1] = pos.y;
+	outMatrix.mat[3][2] = pos.z;
+	outMatrix.mat[3][3] = 1.0f;
+}
+
+bool TransformStore::ComputeWorldTransform(int index)
+{
+	ComputeEntry(index);
+	if (!mChanged[index])
+	{
+		return false;
+	}
+	// The caller informs the owner now, but the children still have to
+	// be updated by the next ComputeWorldTransforms
+	// (any parents computed along the way keep their flags, so their
+	// owners are informed then)
+	mChanged[index] = 0;
+	for (int child = mFirstChildren[index]; child >= 0; child = mNextSiblings[child])
+	{
+		mDirty[child] = 1;
+	}
+	return true;
+}
+
+void TransformStore::ComputeEntry(int index)
+{
+	int parent = mParents[index];
+	if (parent >= 0)
+	{
+		// Make sure the parent is up to date first
+		if (mDirty[parent])
+		{
+			ComputeEntry(parent);
+		}
+		ComputeChild(static_cast<size_t>(index));
+	}
+	else
+	{
+		Matrix4 world;
+		ComputeMatrix(GetPosition(index), GetRotation(index), mScale[index], world);
+		if (std::memcmp(&world, &mWorldTransforms[index], sizeof(Matrix4)) != 0)
+		{
+			mWorldTransforms[index] = world;
+			mChanged[index] = 1;
+		}
+		mDirty[index] = 0;
+	}
+}
+
+void TransformStore::ComputeChild(size_t index)
+{
+	int i = static_cast<int>(index);
+	Matrix4 local;
+	ComputeMatrix(GetPosition(i), GetRotation(i), mScale[i], local);
+	Matrix4 world = local * mWorldTransforms[mParents[i]];
+	if (std::memcmp(&world, &mWorldTransforms[i], sizeof(Matrix4)) != 0)
+	{
+		mWorldTransforms[i] = world;
+		mChanged[i] = 1;
+	}
+	mDirty[i] = 0;
+}
+
+void TransformStore::ComputeBlock(size_t start)
+{
+#ifdef TRANSFORM_STORE_SSE
+	// Each register holds one value for four consecutive entries
+	__m128 x = _mm_loadu_ps(&mRotX[start]);
+	__m128 y = _mm_loadu_ps(&mRotY[start]);
+	__m128 z = _mm_loadu_ps(&mRotZ[start]);
+	__m128 w = _mm_loadu_ps(&mRotW[start]);
+	__m128 s = _mm_loadu_ps(&mScale[start]);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	__m128 x2 = _mm_mul_ps(x, two);
+	__m128 y2 = _mm_mul_ps(y, two);
+	__m128 z2 = _mm_mul_ps(z, two);
+	__m128 xx = _mm_mul_ps(x, x2);
+	__m128 yy = _mm_mul_ps(y, y2);
+	__m128 zz = _mm_mul_ps(z, z2);
+	__m128 xy = _mm_mul_ps(x, y2);
+	__m128 xz = _mm_mul_ps(x, z2);
+	__m128 yz = _mm_mul_ps(y, z2);
+	__m128 wx = _mm_mul_ps(w, x2);
+	__m128 wy = _mm_mul_ps(w, y2);
+	__m128 wz = _mm_mul_ps(w, z2);
+
+	__m128 rows[4][4];
+	rows[0][0] = _mm_mul_ps(s, _mm_sub_ps(one, _mm_add_ps(yy, zz)));
+	rows[0][1] = _mm_mul_ps(s, _mm_add_ps(xy, wz));
+	rows[0][2] = _mm_mul_ps(s, _mm_sub_ps(xz, wy));
+	rows[0][3] = _mm_setzero_ps();
+
+	rows[1][0] = _mm_mul_ps(s, _mm_sub_ps(xy, wz));
+	rows[1][1] = _mm_mul_ps(s, _mm_sub_ps(one, _mm_add_ps(xx, zz)));
+	rows[1][2] = _mm_mul_ps(s, _mm_add_ps(yz, wx));
+	rows[1][3] = _mm_setzero_ps();
+
+	rows[2][0] = _mm_mul_ps(s, _mm_add_ps(xz, wy));
+	rows[2][1] = _mm_mul_ps(s, _mm_sub_ps(yz, wx));
+	rows[2][2] = _mm_mul_ps(s, _mm_sub_ps(one, _mm_add_ps(xx, yy)));
+	rows[2][3] = _mm_setzero_ps();
+
+	rows[3][0] = _mm_loadu_ps(&mPosX[start]);
+	rows[3][1] = _mm_loadu_ps(&mPosY[start]);
+	rows[3][2] = _mm_loadu_ps(&mPosZ[start]);
+	rows[3][3] = one;
+
+	// Transpose so each register is one matrix row of one entry
+	for (int r = 0; r < 4; r++)
+	{
+		_MM_TRANSPOSE4_PS(rows[r][0], rows[r][1], rows[r][2], rows[r][3]);
+	}
+
+	// Only write out the roots that were actually dirty
+	// (entries with a parent are done afterwards, in order)
+	for (size_t lane = 0; lane < 4; lane++)
+	{
+		size_t i = start + lane;
+		if (mDirty[i] && mParents[i] < 0)
+		{
+			// Note whether any element is different from before
+			__m128 diff = _mm_setzero_ps();
+			for (int r = 0; r < 4; r++)
+			{
+				__m128 old = _mm_loadu_ps(mWorldTransforms[i].mat[r]);
+				diff = _mm_or_ps(diff, _mm_cmpneq_ps(old, rows[r][lane]));
+				_mm_storeu_ps(mWorldTransforms[i].mat[r], rows[r][lane]);
+			}
+			if (_mm_movemask_ps(diff) != 0)
+			{
+				mChanged[i] = 1;
+			}
+		}
+	}
+#else
+	for (size_t i = start; i < start + 4; i++)
+	{
+		if (mDirty[i] && mParents[i] < 0)
+		{
+			ComputeEntry(static_cast<int>(i));
+		}
+	}
+#endif
+}
+
+void TransformStore::ComputeWorldTransforms()
+{
+	PROFILE_SCOPE("TransformStore::ComputeWorldTransforms");
+	if (mNeedsSort)
+	{
+		SortHierarchy();
+	}
+
+	size_t count = mOwners.size();
+	size_t numBlocks = count / 4;
+	// Compute in blocks of four, skipping blocks with nothing dirty
+	// (blocks never share entries, so they can run on any thread)
+	auto computeBlocks = [this](size_t begin, size_t end) {
+		for (size_t block = begin; block < end; block++)
+		{
+			size_t i = block * 4;
+			if (mDirty[i] | mDirty[i + 1] | mDirty[i + 2] | mDirty[i + 3])
+			{
+				ComputeBlock(i);
+			}
+		}
+	};
+	if (mJobs)
+	{
+		mJobs->ParallelFor(numBlocks, BlocksPerJob, computeBlocks);
+	}
+	else
+	{
+		computeBlocks(0, numBlocks);
+	}
+	// Then whatever roots are left over
+	for (size_t i = numBlocks * 4; i < count; i++)
+	{
+		if (mDirty[i] && mParents[i] < 0)
+		{
+			ComputeEntry(static_cast<int>(i));
+		}
+	}
+
+	// Now the children, in order, so each parent is done before its
+	// children (only subtrees that are dirty or moved are recomputed)
+	for (size_t i = mFirstChildIndex; i < count; i++)
+	{
+		int parent = mParents[i];
+		if (parent >= 0 && (mDirty[i] || mChanged[parent]))
+		{
+			ComputeChild(i);
+		}
+	}
+
+	// Now gather up everything that changed
+	for (size_t i = 0; i < count; i++)
+	{
+		if (mDirty[i])
+		{
+			mDirty[i] = 0;
+		}
+		if (mChanged[i])
+		{
+			mChanged[i] = 0;
+			mUpdated.emplace_back(static_cast<int>(i));
+		}
+	}
+
+	// Inform the owners once all the matrices are computed
+	for (int index : mUpdated)
+	{
+		mOwners[index]->OnUpdateWorldTransform();
+	}
+	mUpdated.clear();
+}
+
+void TransformStore::SaveHistory()
+{
+	size_t count = mOwners.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		mPrevPositions[i] = Vector3(mPosX[i], mPosY[i], mPosZ[i]);
+		mPrevRotations[i] = Quaternion(mRotX[i], mRotY[i], mRotZ[i], mRotW[i]);
+	}
+	mPrevScales = mScale;
+	std::fill(mMoved.begin(), mMoved.end(), 0);
+	std::fill(mHasHistory.begin(), mHasHistory.end(), 1);
+}
+
+void TransformStore::ComputeRenderTransforms(float alpha)
+{
+	PROFILE_SCOPE("TransformStore::ComputeRenderTransforms");
+	auto computeRange = [this, alpha](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+		{
+			if (mParents[i] >= 0)
+			{
+				// Done below, once the parent is
+				continue;
+			}
+			if (mHasHistory[i] && mMoved[i])
+			{
+				// Interpolate between the previous and current tick
+				int index = static_cast<int>(i);
+				Vector3 pos = Vector3::Lerp(mPrevPositions[i], GetPosition(index), alpha);
+				Quaternion rot = Quaternion::Slerp(mPrevRotations[i], GetRotation(index), alpha);
+				float scale = Math::Lerp(mPrevScales[i], mScale[i], alpha);
+				ComputeMatrix(pos, rot, scale, mRenderTransforms[i]);
+			}
+			else
+			{
+				// Didn't move last tick, so draw at the current transform
+				mRenderTransforms[i] = mWorldTransforms[i];
+			}
+		}
+	};
+
+	size_t count = mOwners.size();
+	if (mJobs)
+	{
+		mJobs->ParallelFor(count, RenderEntriesPerJob, computeRange);
+	}
+	else
+	{
+		computeRange(0, count);
+	}
+
+	// Children are relative to their parent's render transform
+	for (size_t i = mFirstChildIndex; i < count; i++)
+	{
+		int parent = mParents[i];
+		if (parent < 0)
+		{
+			continue;
+		}
+		int index = static_cast<int>(i);
+		Matrix4 local;
+		if (mHasHistory[i] && mMoved[i])
+		{
+			Vector3 pos = Vector3::Lerp(mPrevPositions[i], GetPosition(index), alpha);
+			Quaternion rot = Quaternion::Slerp(mPrevRotations[i], GetRotation(index), alpha);
+			float scale = Math::Lerp(mPrevScales[i], mScale[i], alpha);
+			ComputeMatrix(pos, rot, scale, local);
+		}
+		else
+		{
+			ComputeMatrix(GetPosition(index), GetRotation(index), mScale[i], local);
+		}
+		mRenderTransforms[i] = local * mRenderTransforms[parent];
+	}
+}
@@ -0,0 +1,134 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Math.h"
+
+// Stores the transforms of every actor as a structure of arrays,
+// so world matrices can be computed in one batched pass
+// Entries can have a parent, in which case position, rotation and
+// scale are relative to the parent. Entries are kept in breadth-first
+// order, so parents always come before their children
+class TransformStore
+{
+public:
+	TransformStore(class JobSystem* jobs);
+
+	// Add a transform for the actor, and return its index
+	int Add(class Actor* owner);
+	// Remove the transform at index (the last transform is moved
+	// into its place, and its owner is told its new index)
+	// Any children are detached, staying where they are in the world
+	void Remove(int index);
+
+	// Attach the entry to a parent (or detach it, if parent is -1)
+	// The relative transform is kept as is, so the entry moves with
+	// its new parent. Returns false if this would make a cycle
+	bool SetParent(int index, int parent);
+	int GetParent(int index) const { return mParents[index]; }
+	class Actor* GetOwner(int index) const { return mOwners[index]; }
+
+	size_t GetNumTransforms() const { return mOwners.size(); }
+
+	// Getters/setters
+	Vector3 GetPosition(int index) const
+	{
+		return Vector3(mPosX[index], mPosY[index], mPosZ[index]);
+	}
+	void SetPosition(int index, const Vector3& pos);
+	Quaternion GetRotation(int index) const
+	{
+		return Quaternion(mRotX[index], mRotY[index], mRotZ[index], mRotW[index]);
+	}
+	void SetRotation(int index, const Quaternion& rotation);
+	float GetScale(int index) const { return mScale[index]; }
+	void SetScale(int index, float scale);
+
+	const Matrix4& GetWorldTransform(int index) const { return mWorldTransforms[index]; }
+	const Matrix4& GetRenderTransform(int index) const { return mRenderTransforms[index]; }
+	bool IsDirty(int index) const { return mDirty[index] != 0; }
+	// Transform of the entry relative to the world (not its parent)
+	// Computed from the current values, so it's valid even if dirty
+	void GetWorldPose(int index, Vector3& outPos, Quaternion& outRot,
+		float& outScale) const;
+
+	// Compute the world transform of a single entry right away,
+	// returning true if it changed (the caller then informs the owner,
+	// so the next ComputeWorldTransforms won't, but it still updates
+	// the entry's children)
+	bool ComputeWorldTransform(int index);
+	// Compute the world transforms of all dirty entries (and their
+	// children), then inform the owners of any that actually changed
+	// (the matrices are computed in parallel, but owners are
+	// always informed on the calling thread)
+	void ComputeWorldTransforms();
+
+	// Save the current transforms as the previous simulation state
+	void SaveHistory();
+	// Compute the transforms to draw with, interpolated by alpha
+	// between the previous and current simulation state
+	// (world transforms must already be up to date)
+	void ComputeRenderTransforms(float alpha);
+private:
+	// Scale, then rotate, then translate (without intermediate matrices)
+	static void ComputeMatrix(const Vector3& pos, const Quaternion& rot,
+		float scale, Matrix4& outMatrix);
+	// Compute world transforms of root entries [start, start + 4)
+	void ComputeBlock(size_t start);
+	// Compute the world transform of an entry (and any dirty parents)
+	void ComputeEntry(int index);
+	// Compute the world transform of an entry with a parent
+	void ComputeChild(size_t index);
+	// Unlink the entry from its parent's list of children
+	void Unlink(int index);
+	// Sort the entries back into breadth-first order
+	void SortHierarchy();
+
+	// Current simulation state
+	std::vector<float> mPosX;
+	std::vector<float> mPosY;
+	std::vector<float> mPosZ;
+	std::vector<float> mRotX;
+	std::vector<float> mRotY;
+	std::vector<float> mRotZ;
+	std::vector<float> mRotW;
+	std::vector<float> mScale;
+
+	// State at the start of the last simulation tick
+	std::vector<Vector3> mPrevPositions;
+	std::vector<Quaternion> mPrevRotations;
+	std::vector<float> mPrevScales;
+
+	std::vector<Matrix4> mWorldTransforms;
+	std::vector<Matrix4> mRenderTransforms;
+
+	// World transform needs to be recomputed
+	std::vector<uint8_t> mDirty;
+	// Transform changed during the last simulation tick
+	std::vector<uint8_t> mMoved;
+	// World transform actually changed (owner needs to be informed)
+	std::vector<uint8_t> mChanged;
+	// Previous state is valid (false until the first tick)
+	std::vector<uint8_t> mHasHistory;
+
+	std::vector<class Actor*> mOwners;
+	// Hierarchy (-1 for none)
+	std::vector<int> mParents;
+	std::vector<int> mFirstChildren;
+	std::vector<int> mNextSiblings;
+	// Index of the first entry with a parent (everything before
+	// it is a root, so it doesn't need to be checked)
+	size_t mFirstChildIndex;
+	// Whether the entries are out of breadth-first order
+	bool mNeedsSort;
+	// Entries whose owners need to be informed of a new transform
+	std::vector<int> mUpdated;
+	class JobSystem* mJobs;
+};
@@ -8,14 +8,15 @@
 
 #include "UIScreen.h"
 #include "Texture.h"
-#include "Shader.h"
+#include "SpriteBatch.h"
 #include "Game.h"
 #include "Renderer.h"
 #include "Font.h"
 
 UIScreen::UIScreen(Game* game)
 	:mGame(game)
-	,mTitle(nullptr)
+	,mTitleColor(Color::White)
+	,mTitlePointSize(40)
 	,mBackground(nullptr)
 	,mTitlePos(0.0f, 300.0f)
 	,mNextButtonPos(0.0f, 200.0f)
@@ -31,12 +32,6 @@ UIScreen::UIScreen(Game* game)
 
 UIScreen::~UIScreen()
 {
-	if (mTitle)
-	{
-		mTitle->Unload();
-		delete mTitle;
-	}
-
 	for (auto b : mButtons)
 	{
 		delete b;
@@ -49,26 +44,33 @@ void UIScreen::Update(float deltaTime)
 	
 }
 
-void UIScreen::Draw(Shader* shader)
+void UIScreen::Draw(SpriteBatch* batch)
 {
 	// Draw background (if exists)
 	if (mBackground)
 	{
-		DrawTexture(shader, mBackground, mBGPos);
+		DrawTexture(batch, mBackground, mBGPos);
 	}
-	// Draw title (if exists)
-	if (mTitle)
-	{
-		DrawTexture(shader, mTitle, mTitlePos);
-	}
-	// Draw buttons
+	// Draw background of buttons
 	for (auto b : mButtons)
 	{
-		// Draw background of button
 		Texture* tex = b->GetHighlighted() ? mButtonOn : mButtonOff;
-		DrawTexture(shader, tex, b->GetPosition());
-		// Draw text of button
-		DrawTexture(shader, b->GetNameTex(), b->GetPosition());
+		DrawTexture(batch, tex, b->GetPosition());
+	}
+	// Then all the text, which shares the font's glyph atlas
+	// (nothing overlaps, so this order only saves texture changes)
+	if (mFont)
+	{
+		// Draw title (if exists)
+		if (!mTitle.empty())
+		{
+			mFont->DrawString(batch, mTitle, mTitlePos, mTitleColor, mTitlePointSize);
+		}
+		// Draw text of buttons
+		for (auto b : mButtons)
+		{
+			mFont->DrawString(batch, b->GetName(), b->GetPosition());
+		}
 	}
 	// Override in subclasses to draw any textures
 }
@@ -132,21 +134,17 @@ void UIScreen::SetTitle(const std::string& text,
 						const Vector3& color,
 						int pointSize)
 {
-	// Clear out previous title texture if it exists
-	if (mTitle)
-	{
-		mTitle->Unload();
-		delete mTitle;
-		mTitle = nullptr;
-	}
-	mTitle = mFont->RenderText(text, color, pointSize);
+	// Text is laid out as it's drawn, so just save it
+	mTitle = text;
+	mTitleColor = color;
+	mTitlePointSize = pointSize;
 }
 
 void UIScreen::AddButton(const std::string& name, std::function<void()> onClick)
 {
 	Vector2 dims(static_cast<float>(mButtonOn->GetWidth()), 
 		static_cast<float>(mButtonOn->GetHeight()));
-	Button* b = new Button(name, mFont, onClick, mNextButtonPos, dims);
+	Button* b = new Button(name, onClick, mNextButtonPos, dims);
 	mButtons.emplace_back(b);
 
 	// Update position of next button
@@ -154,7 +152,7 @@ void UIScreen::AddButton(const std::string& name, std::function<void()> onClick)
 	mNextButtonPos.y -= mButtonOff->GetHeight() + 20.0f;
 }
 
-void UIScreen::DrawTexture(class Shader* shader, class Texture* texture,
+void UIScreen::DrawTexture(class SpriteBatch* batch, class Texture* texture,
 				 const Vector2& offset, float scale, bool flipY)
 {
 	// Scale the quad by the width/height of texture
@@ -171,13 +169,9 @@ void UIScreen::DrawTexture(class Shader* shader, class Texture* texture,
 	Matrix4 transMat = Matrix4::CreateTranslation(
 		Vector3(offset.x, offset.y, 0.0f));
 
-	// Set world transform
+	// Add the quad to the batch
 	Matrix4 world = scaleMat * transMat;
-	shader->SetMatrixUniform("uWorldTransform", world);
-	// Set current texture
-	texture->SetActive();
-	// Draw quad
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+	batch->Draw(texture, world);
 }
 
 void UIScreen::SetRelativeMouseMode(bool relative)
@@ -194,39 +188,19 @@ void UIScreen::SetRelativeMouseMode(bool relative)
 	}
 }
 
-Button::Button(const std::string& name, Font* font,
+Button::Button(const std::string& name,
 	std::function<void()> onClick,
 	const Vector2& pos, const Vector2& dims)
 	:mOnClick(onClick)
-	,mNameTex(nullptr)
-	,mFont(font)
+	,mName(name)
 	,mPosition(pos)
 	,mDimensions(dims)
 	,mHighlighted(false)
 {
-	SetName(name);
 }
 
 Button::~Button()
 {
-	if (mNameTex)
-	{
-		mNameTex->Unload();
-		delete mNameTex;
-	}
-}
-
-void Button::SetName(const std::string& name)
-{
-	mName = name;
-
-	if (mNameTex)
-	{
-		mNameTex->Unload();
-		delete mNameTex;
-		mNameTex = nullptr;
-	}
-	mNameTex = mFont->RenderText(mName);
 }
 
 bool Button::ContainsPoint(const Vector2& pt) const
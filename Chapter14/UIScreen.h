@@ -16,16 +16,16 @@
 class Button
 {
 public:
-	Button(const std::string& name, class Font* font,
+	Button(const std::string& name,
 		std::function<void()> onClick,
 		const Vector2& pos, const Vector2& dims);
 	~Button();
 
-	// Set the name of the button
-	void SetName(const std::string& name);
+	// Set the name of the button (a text key)
+	void SetName(const std::string& name) { mName = name; }
 	
 	// Getters/setters
-	class Texture* GetNameTex() { return mNameTex; }
+	const std::string& GetName() const { return mName; }
 	const Vector2& GetPosition() const { return mPosition; }
 	void SetHighlighted(bool sel) { mHighlighted = sel; }
 	bool GetHighlighted() const { return mHighlighted; }
@@ -37,8 +37,6 @@ public:
 private:
 	std::function<void()> mOnClick;
 	std::string mName;
-	class Texture* mNameTex;
-	class Font* mFont;
 	Vector2 mPosition;
 	Vector2 mDimensions;
 	bool mHighlighted;
@@ -51,7 +49,7 @@ public:
 	virtual ~UIScreen();
 	// UIScreen subclasses can override these
 	virtual void Update(float deltaTime);
-	virtual void Draw(class Shader* shader);
+	virtual void Draw(class SpriteBatch* batch);
 	virtual void ProcessInput(const uint8_t* keys);
 	virtual void HandleKeyPress(int key);
 	// Tracks if the UI is active or closing
@@ -72,7 +70,7 @@ public:
 	void AddButton(const std::string& name, std::function<void()> onClick);
 protected:
 	// Helper to draw a texture
-	void DrawTexture(class Shader* shader, class Texture* texture,
+	void DrawTexture(class SpriteBatch* batch, class Texture* texture,
 					 const Vector2& offset = Vector2::Zero,
 					 float scale = 1.0f,
 					 bool flipY = false);
@@ -81,7 +79,10 @@ protected:
 	class Game* mGame;
 	
 	class Font* mFont;
-	class Texture* mTitle;
+	// Title text key, drawn with mFont
+	std::string mTitle;
+	Vector3 mTitleColor;
+	int mTitlePointSize;
 	class Texture* mBackground;
 	class Texture* mButtonOn;
 	class Texture* mButtonOff;
@@ -8,16 +8,21 @@
 
 #include "VertexArray.h"
 #include <GL/glew.h>
+#include <cstdint>
+#include <vector>
 
 VertexArray::VertexArray(const void* verts, unsigned int numVerts, Layout layout,
 	const unsigned int* indices, unsigned int numIndices)
-	:mNumVerts(numVerts)
+	:mLayout(layout)
+	,mNumVerts(numVerts)
 	,mNumIndices(numIndices)
+	,mIndexType(GL_UNSIGNED_INT)
+	,mIndexSize(sizeof(unsigned int))
+	,mPositionScale(1.0f, 1.0f, 1.0f)
+	,mPositionOffset(Vector3::Zero)
+	,mVertexArray(0)
+	,mInstancedArray(0)
 {
-	// Create vertex array
-	glGenVertexArrays(1, &mVertexArray);
-	glBindVertexArray(mVertexArray);
-
 	unsigned vertexSize = GetVertexSize(layout);
 
 	// Create vertex buffer
@@ -26,12 +31,80 @@ VertexArray::VertexArray(const void* verts, unsigned int numVerts, Layout layout
 	glBufferData(GL_ARRAY_BUFFER, numVerts * vertexSize, verts, GL_STATIC_DRAW);
 
 	// Create index buffer
+	// (through the array buffer target, since the element array
+	// binding belongs to a vertex array object, which isn't made yet)
 	glGenBuffers(1, &mIndexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mIndexBuffer);
+	if (numVerts <= 0x10000)
+	{
+		// Half the size, if every index fits in 16 bits
+		std::vector<uint16_t> shortIndices(indices, indices + numIndices);
+		mIndexType = GL_UNSIGNED_SHORT;
+		mIndexSize = sizeof(uint16_t);
+		glBufferData(GL_ARRAY_BUFFER, numIndices * mIndexSize, shortIndices.data(),
+			GL_STATIC_DRAW);
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, numIndices * mIndexSize, indices, GL_STATIC_DRAW);
+	}
+}
+
+VertexArray::~VertexArray()
+{
+	glDeleteBuffers(1, &mVertexBuffer);
+	glDeleteBuffers(1, &mIndexBuffer);
+	if (mVertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &mVertexArray);
+	}
+	if (mInstancedArray != 0)
+	{
+		glDeleteVertexArrays(1, &mInstancedArray);
+	}
+}
+
+void VertexArray::SetActive()
+{
+	if (mVertexArray == 0)
+	{
+		CreateArray(mVertexArray);
+	}
+	glBindVertexArray(mVertexArray);
+}
+
+void VertexArray::SetActiveInstanced(unsigned int numInstanceAttribs)
+{
+	if (mInstancedArray == 0)
+	{
+		CreateArray(mInstancedArray);
+		for (GLuint i = 0; i < numInstanceAttribs; i++)
+		{
+			glEnableVertexAttribArray(3 + i);
+			glVertexAttribDivisor(3 + i, 1);
+		}
+	}
+	glBindVertexArray(mInstancedArray);
+}
+
+void VertexArray::SetPositionDecode(const Vector3& scale, const Vector3& offset)
+{
+	mPositionScale = scale;
+	mPositionOffset = offset;
+}
+
+void VertexArray::CreateArray(unsigned int& outArray)
+{
+	// Create vertex array
+	glGenVertexArrays(1, &outArray);
+	glBindVertexArray(outArray);
+	glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+
+	unsigned vertexSize = GetVertexSize(mLayout);
 
 	// Specify the vertex attributes
-	if (layout == PosNormTex)
+	if (mLayout == PosNormTex)
 	{
 		// Position is 3 floats
 		glEnableVertexAttribArray(0);
@@ -45,7 +118,7 @@ VertexArray::VertexArray(const void* verts, unsigned int numVerts, Layout layout
 		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertexSize,
 			reinterpret_cast<void*>(sizeof(float) * 6));
 	}
-	else if (layout == PosNormSkinTex)
+	else if (mLayout == PosNormSkinTex)
 	{
 		// Position is 3 floats
 		glEnableVertexAttribArray(0);
@@ -67,18 +140,42 @@ VertexArray::VertexArray(const void* verts, unsigned int numVerts, Layout layout
 		glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, vertexSize,
 			reinterpret_cast<void*>(sizeof(float) * 6 + sizeof(char) * 8));
 	}
-}
-
-VertexArray::~VertexArray()
-{
-	glDeleteBuffers(1, &mVertexBuffer);
-	glDeleteBuffers(1, &mIndexBuffer);
-	glDeleteVertexArrays(1, &mVertexArray);
-}
-
-void VertexArray::SetActive()
-{
-	glBindVertexArray(mVertexArray);
+	else if (mLayout == PosNormTexPacked)
+	{
+		// Position is 3 normalized shorts (and one for padding)
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, vertexSize, 0);
+		// Normal is 10:10:10:2 (w unused)
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, vertexSize,
+			reinterpret_cast<void*>(sizeof(uint16_t) * 4));
+		// Texture coordinates is 2 half floats
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, vertexSize,
+			reinterpret_cast<void*>(sizeof(uint16_t) * 4 + sizeof(uint32_t)));
+	}
+	else if (mLayout == PosNormSkinTexPacked)
+	{
+		// Position is 3 normalized shorts (and one for padding)
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, vertexSize, 0);
+		// Normal is 10:10:10:2 (w unused)
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, vertexSize,
+			reinterpret_cast<void*>(sizeof(uint16_t) * 4));
+		// Skinning indices (keep as ints)
+		glEnableVertexAttribArray(2);
+		glVertexAttribIPointer(2, 4, GL_UNSIGNED_BYTE, vertexSize,
+			reinterpret_cast<void*>(sizeof(uint16_t) * 4 + sizeof(uint32_t)));
+		// Skinning weights (convert to floats)
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, vertexSize,
+			reinterpret_cast<void*>(sizeof(uint16_t) * 4 + sizeof(uint32_t) + sizeof(char) * 4));
+		// Texture coordinates is 2 half floats
+		glEnableVertexAttribArray(4);
+		glVertexAttribPointer(4, 2, GL_HALF_FLOAT, GL_FALSE, vertexSize,
+			reinterpret_cast<void*>(sizeof(uint16_t) * 4 + sizeof(uint32_t) + sizeof(char) * 8));
+	}
 }
 
 unsigned int VertexArray::GetVertexSize(VertexArray::Layout layout)
@@ -88,5 +185,20 @@ unsigned int VertexArray::GetVertexSize(VertexArray::Layout layout)
 	{
 		vertexSize = 8 * sizeof(float) + 8 * sizeof(char);
 	}
+	else if (layout == PosNormTexPacked)
+	{
+		// Position, normal, tex coords
+		vertexSize = 4 * sizeof(uint16_t) + sizeof(uint32_t) + 2 * sizeof(uint16_t);
+	}
+	else if (layout == PosNormSkinTexPacked)
+	{
+		vertexSize = 4 * sizeof(uint16_t) + sizeof(uint32_t) + 8 * sizeof(char) +
+			2 * sizeof(uint16_t);
+	}
 	return vertexSize;
 }
+
+bool VertexArray::IsPacked(VertexArray::Layout layout)
+{
+	return layout == PosNormTexPacked || layout == PosNormSkinTexPacked;
+}
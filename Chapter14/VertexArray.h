@@ -7,34 +7,70 @@
 // ----------------------------------------------------------------
 
 #pragma once
+#include "Math.h"
+
 class VertexArray
 {
 public:
 	// Different supported vertex layouts
+	// (the packed ones have 16-bit positions, normalized in the box
+	// set by SetPositionDecode, 10:10:10:2 normals and half float UVs)
 	enum Layout
 	{
 		PosNormTex,
-		PosNormSkinTex
+		PosNormSkinTex,
+		PosNormTexPacked,
+		PosNormSkinTexPacked
 	};
 
+	// Indices are stored as 16-bit if every vertex fits
 	VertexArray(const void* verts, unsigned int numVerts, Layout layout,
 		const unsigned int* indices, unsigned int numIndices);
 	~VertexArray();
 
+	// (The vertex array object is made the first time this is called,
+	// since they can't be shared between GL contexts)
 	void SetActive();
+	// Bind a separate vertex array object for instanced draws, with the
+	// same buffers and attributes plus numInstanceAttribs per instance
+	// attributes from location 3 on (enabled with a divisor of 1, for
+	// the caller to point at its instance data). Not for skinned
+	// layouts, which use those locations for skinning
+	void SetActiveInstanced(unsigned int numInstanceAttribs);
 	unsigned int GetNumIndices() const { return mNumIndices; }
 	unsigned int GetNumVerts() const { return mNumVerts; }
+	unsigned int GetArrayID() const { return mVertexArray; }
+	// GL type and size of the indices
+	unsigned int GetIndexType() const { return mIndexType; }
+	unsigned int GetIndexSize() const { return mIndexSize; }
+
+	// Packed positions (0-1) are scaled then offset by these in the
+	// vertex shader (uPosScale/uPosOffset), which does nothing by default
+	void SetPositionDecode(const Vector3& scale, const Vector3& offset);
+	const Vector3& GetPositionScale() const { return mPositionScale; }
+	const Vector3& GetPositionOffset() const { return mPositionOffset; }
 
 	static unsigned int GetVertexSize(VertexArray::Layout layout);
+	static bool IsPacked(VertexArray::Layout layout);
 private:
+	// Create a vertex array object and specify the attributes
+	void CreateArray(unsigned int& outArray);
+
+	Layout mLayout;
 	// How many vertices in the vertex buffer?
 	unsigned int mNumVerts;
 	// How many indices in the index buffer
 	unsigned int mNumIndices;
+	unsigned int mIndexType;
+	unsigned int mIndexSize;
+	Vector3 mPositionScale;
+	Vector3 mPositionOffset;
 	// OpenGL ID of the vertex buffer
 	unsigned int mVertexBuffer;
 	// OpenGL ID of the index buffer
 	unsigned int mIndexBuffer;
 	// OpenGL ID of the vertex array object
 	unsigned int mVertexArray;
+	// And of the one for instanced draws (0 until it's used)
+	unsigned int mInstancedArray;
 };
\ No newline at end of file